@@ -0,0 +1,158 @@
+// Hash context files.
+//
+// sha256open() returns a file descriptor for a fresh SHA-256
+// context held by the kernel. Each write() to it adds the bytes
+// written to the message, so a process can hash data as it arrives
+// without keeping it. read() returns the digest of everything
+// written so far, 32 bytes and then end of file; the next write()
+// continues the same message and rewinds the digest. sha256clone()
+// opens a second context with the state of an existing one, so a
+// common prefix is hashed only once.
+//
+// Reads and writes come through fileread() and filewrite(); the
+// context is freed when the last descriptor for it is closed.
+
+#include "types.h"
+#include "riscv.h"
+#include "defs.h"
+#include "param.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "fs.h"
+#include "sleeplock.h"
+#include "file.h"
+#include "sha256.h"
+
+#define NHASHFILE 32
+
+struct hashfile {
+  struct sleeplock lock;    // protects ctx, and off in the file
+  int used;                 // protected by hashtab.lock
+  struct sha256_ctx ctx;
+};
+
+struct {
+  struct spinlock lock;
+  struct hashfile hf[NHASHFILE];
+} hashtab;
+
+void
+hashfileinit(void)
+{
+  struct hashfile *hf;
+
+  initlock(&hashtab.lock, "hashtab");
+  for(hf = hashtab.hf; hf < hashtab.hf + NHASHFILE; hf++)
+    initsleeplock(&hf->lock, "hashfile");
+}
+
+// Open a hash context in the current process, starting from the
+// state of from, or from the empty message if from is 0.
+// Returns the new file descriptor, or -1.
+int
+hashfileopen(struct hashfile *from)
+{
+  struct proc *p = myproc();
+  struct hashfile *hf;
+  struct file *f;
+  int fd;
+
+  for(fd = 0; fd < NOFILE; fd++)
+    if(p->ofile[fd] == 0)
+      break;
+  if(fd == NOFILE)
+    return -1;
+
+  acquire(&hashtab.lock);
+  for(hf = hashtab.hf; hf < hashtab.hf + NHASHFILE; hf++)
+    if(!hf->used)
+      break;
+  if(hf == hashtab.hf + NHASHFILE){
+    release(&hashtab.lock);
+    return -1;
+  }
+  hf->used = 1;
+  release(&hashtab.lock);
+
+  if((f = filealloc()) == 0){
+    acquire(&hashtab.lock);
+    hf->used = 0;
+    release(&hashtab.lock);
+    return -1;
+  }
+
+  if(from){
+    acquiresleep(&from->lock);
+    hf->ctx = from->ctx;
+    releasesleep(&from->lock);
+  } else {
+    sha256_init(&hf->ctx);
+  }
+  f->type = FD_HASH;
+  f->readable = 1;
+  f->writable = 1;
+  f->hash = hf;
+  f->off = 0;
+  p->ofile[fd] = f;
+  return fd;
+}
+
+void
+hashfileclose(struct hashfile *hf)
+{
+  acquire(&hashtab.lock);
+  memset(&hf->ctx, 0, sizeof(hf->ctx));
+  hf->used = 0;
+  release(&hashtab.lock);
+}
+
+// Add n bytes at user address addr to the message. The context is
+// left as it was if any of them cannot be read.
+int
+hashfilewrite(struct file *f, uint64 addr, int n)
+{
+  struct hashfile *hf = f->hash;
+  struct sha256_ctx ctx;
+
+  if(n < 0)
+    return -1;
+  acquiresleep(&hf->lock);
+  ctx = hf->ctx;
+  if(sha256_uvm(myproc()->pagetable, &ctx, addr, n) < 0){
+    releasesleep(&hf->lock);
+    return -1;
+  }
+  hf->ctx = ctx;
+  f->off = 0;
+  releasesleep(&hf->lock);
+  return n;
+}
+
+// Copy up to n bytes of the digest so far to user address addr,
+// from offset f->off. The context itself is not finalized.
+int
+hashfileread(struct file *f, uint64 addr, int n)
+{
+  struct hashfile *hf = f->hash;
+  struct sha256_ctx ctx;
+  uchar digest[SHA256_DIGEST_SIZE];
+
+  if(n < 0)
+    return -1;
+  acquiresleep(&hf->lock);
+  if(f->off >= SHA256_DIGEST_SIZE){
+    releasesleep(&hf->lock);
+    return 0;
+  }
+  if(n > SHA256_DIGEST_SIZE - f->off)
+    n = SHA256_DIGEST_SIZE - f->off;
+  ctx = hf->ctx;
+  sha256_final(&ctx, digest);
+  if(copyout(myproc()->pagetable, addr, (char*)digest + f->off, n) < 0){
+    releasesleep(&hf->lock);
+    return -1;
+  }
+  f->off += n;
+  releasesleep(&hf->lock);
+  return n;
+}
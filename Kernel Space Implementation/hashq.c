@@ -0,0 +1,182 @@
+// Hashing work queue.
+//
+// Every hart starts one worker process (hashqinithart). A system
+// call that has several independent messages to hash submits them
+// as a group of jobs, sleeps, and is woken once the workers have
+// finished the whole group, so the work spreads over all harts
+// instead of running on the caller's.
+//
+// The workers read user memory through the submitter's page table,
+// which cannot change while the submitter sleeps in hashqwait().
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "sha256.h"
+#include "hashq.h"
+
+// Groups with less input than this are hashed on the caller's
+// hart; waking the workers would cost more than it saves.
+#define HASHQ_MINBYTES 4096
+
+struct {
+  struct spinlock lock;
+  struct hashjob *head;     // queued jobs, oldest first
+  struct hashjob *tail;
+  int nworkers;             // worker processes started
+  int active;               // workers allowed to take jobs
+} hq;
+
+void
+hashqinit(void)
+{
+  initlock(&hq.lock, "hashq");
+}
+
+static int
+hashjobrun(struct hashjob *j)
+{
+  struct sha256_ctx ctx;
+
+  if(j->run)
+    return j->run(j);
+  if(j->leaf)
+    sha256_leaf_init(&ctx);
+  else
+    sha256_init(&ctx);
+  if(j->pagetable){
+    if(sha256_uvm(j->pagetable, &ctx, j->input, j->len) < 0)
+      return -1;
+  } else {
+    sha256_update(&ctx, (uchar*)j->input, j->len);
+  }
+  sha256_final(&ctx, j->output);
+  return 0;
+}
+
+// Worker process body. Workers numbered at or above hq.active
+// stay asleep, which lets benchmarks measure 1..N harts.
+static void
+hashworker(void *arg)
+{
+  int id = (int)(uint64)arg;
+  struct hashjob *j;
+  struct hashgroup *g;
+  int r;
+
+  // the first worker to run checks the SHA-256 code, off the boot path.
+  sha256_selftest();
+
+  acquire(&hq.lock);
+  for(;;){
+    while(id >= hq.active || hq.head == 0)
+      sleep(&hq, &hq.lock);
+    j = hq.head;
+    hq.head = j->next;
+    if(hq.head == 0)
+      hq.tail = 0;
+    release(&hq.lock);
+
+    r = hashjobrun(j);
+
+    acquire(&hq.lock);
+    // once pending reaches 0 the submitter may return from
+    // hashqwait() and free the page holding j, or pop the stack
+    // frame holding g, so touch neither after the decrement.
+    g = j->group;
+    if(r < 0)
+      g->failed = 1;
+    if(--g->pending == 0)
+      wakeup(g);
+  }
+}
+
+// Start this hart's worker.
+void
+hashqinithart(void)
+{
+  int id;
+
+  acquire(&hq.lock);
+  id = hq.nworkers++;
+  hq.active = hq.nworkers;
+  release(&hq.lock);
+
+  if(kproc(hashworker, (void*)(uint64)id, "hashworker") < 0)
+    panic("hashqinithart");
+}
+
+// Queue n jobs as group g. Small groups, or any group when there
+// are no workers, run right away on the caller's hart.
+void
+hashqsubmit(struct hashgroup *g, struct hashjob *jobs, int n)
+{
+  uint64 total = 0;
+  int i;
+
+  g->pending = n;
+  g->failed = 0;
+  if(n == 0)
+    return;
+  for(i = 0; i < n; i++)
+    total += jobs[i].len;
+
+  acquire(&hq.lock);
+  if(hq.active == 0 || n == 1 || total < HASHQ_MINBYTES){
+    release(&hq.lock);
+    for(i = 0; i < n; i++)
+      if(hashjobrun(&jobs[i]) < 0)
+        g->failed = 1;
+    g->pending = 0;
+    return;
+  }
+  for(i = 0; i < n; i++){
+    jobs[i].group = g;
+    jobs[i].next = 0;
+    if(hq.tail)
+      hq.tail->next = &jobs[i];
+    else
+      hq.head = &jobs[i];
+    hq.tail = &jobs[i];
+  }
+  wakeup(&hq);
+  release(&hq.lock);
+}
+
+// Wait for every job in g to finish.
+// Returns -1 if any of them failed.
+int
+hashqwait(struct hashgroup *g)
+{
+  acquire(&hq.lock);
+  while(g->pending > 0)
+    sleep(g, &hq.lock);
+  release(&hq.lock);
+  return g->failed ? -1 : 0;
+}
+
+// Let only the first n workers take jobs.
+// Returns the number now active.
+int
+hashqworkers(int n)
+{
+  acquire(&hq.lock);
+  if(n < 1)
+    n = 1;
+  if(n > hq.nworkers)
+    n = hq.nworkers;
+  hq.active = n;
+  wakeup(&hq);
+  release(&hq.lock);
+  return n;
+}
+
+int
+hashqnworkers(void)
+{
+  return hq.nworkers;
+}
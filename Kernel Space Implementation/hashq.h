@@ -0,0 +1,29 @@
+// Kernel hashing work queue, drained by one worker process per hart.
+
+// One message to hash. Input is a user address in pagetable, or a
+// kernel address if pagetable is 0. A job with run set calls
+// run(job) instead; input then points at its arguments, and len is
+// an estimate of the bytes it will compress.
+struct hashjob {
+  pagetable_t pagetable;
+  uint64 input;
+  uint64 len;
+  uchar *output;            // kernel address for the 32-byte digest
+  int leaf;                 // hash as a tree leaf (0x00 prefix)
+  int (*run)(struct hashjob*); // returns -1 on failure
+  struct hashgroup *group;
+  struct hashjob *next;     // hashq list
+};
+
+// Jobs submitted together; the submitter waits for all of them.
+struct hashgroup {
+  int pending;              // jobs not yet finished
+  int failed;               // set if any job could not read its input
+};
+
+void            hashqinit(void);
+void            hashqinithart(void);
+void            hashqsubmit(struct hashgroup*, struct hashjob*, int);
+int             hashqwait(struct hashgroup*);
+int             hashqworkers(int);
+int             hashqnworkers(void);
@@ -0,0 +1,249 @@
+// Hashing rings.
+//
+// A process that hashes many small messages can skip the system call
+// per message. sha256ring() maps a page shared with the kernel into
+// the process, holding a submission queue and a completion queue
+// (struct sha256_ring in sha256.h). The process appends requests to
+// the submission queue and rings the doorbell with sha256ringenter()
+// once per batch; the hashring worker process drains the queue in
+// the background and posts each digest to the completion queue,
+// where the process reaps it without entering the kernel.
+//
+// The page is allocated by the kernel and mapped just below the
+// trapframe, outside the process's sz, so fork() does not copy it
+// and the ring is freed on exit() and exec().
+//
+// The worker reads request data through the owner's page table.
+// r->lock, a sleep lock, is held while it does, and by anything
+// that changes that page table: exit(), exec() (through
+// proc_freepagetable()) and sbrk() (growproc()).
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "proc.h"
+#include "defs.h"
+#include "sha256.h"
+
+#define NHASHRING 16
+#define HASHRING (TRAPFRAME - PGSIZE)   // user address of the shared page
+
+struct hashring {
+  struct sleeplock lock;    // held while the ring is drained or changed
+  int used;                 // owned by a process; protected by ringtab.lock
+  int doorbell;             // requests posted; protected by ringtab.lock
+  int busy;                 // worker is draining; protected by ringtab.lock
+  pagetable_t pagetable;    // owner's page table
+  struct sha256_ring *sh;   // the shared page, at its kernel address
+};
+
+struct {
+  struct spinlock lock;
+  struct hashring ring[NHASHRING];
+} ringtab;
+
+// Post completions for queued requests until the submission queue
+// is empty or the completion queue is full.
+// Caller holds r->lock.
+static void
+hashringdrain(struct hashring *r)
+{
+  struct sha256_ring *sh = r->sh;
+  struct sha256_sqe sqe;
+  struct sha256_cqe *cqe;
+  struct sha256_ctx ctx;
+  uint head, tail;
+
+  head = sh->sq_head;
+  for(;;){
+    tail = sh->sq_tail;
+    if(head == tail || tail - head > SHA256_RING_SQ)
+      break;                  // empty, or a tail the process made up
+    if(sh->cq_tail - sh->cq_head >= SHA256_RING_CQ)
+      break;                  // full until the process reaps
+    __sync_synchronize();     // read the entry after its tail
+    sqe = sh->sq[head % SHA256_RING_SQ];
+
+    cqe = &sh->cq[sh->cq_tail % SHA256_RING_CQ];
+    cqe->user_data = sqe.user_data;
+    cqe->status = 0;
+    sha256_init(&ctx);
+    if(sqe.input >= MAXVA || sha256_uvm(r->pagetable, &ctx, sqe.input, sqe.len) < 0){
+      cqe->status = -1;
+      memset(cqe->digest, 0, SHA256_DIGEST_SIZE);
+    } else {
+      sha256_final(&ctx, cqe->digest);
+    }
+    sh->sq_head = ++head;
+    __sync_synchronize();     // publish the completion before its tail
+    sh->cq_tail++;
+
+    acquire(&ringtab.lock);
+    wakeup(r);
+    release(&ringtab.lock);
+  }
+}
+
+// Worker process body: drain rings whose doorbell has rung.
+static void
+hashringworker(void *arg)
+{
+  struct hashring *r;
+
+  acquire(&ringtab.lock);
+  for(;;){
+    for(r = ringtab.ring; r < ringtab.ring + NHASHRING; r++)
+      if(r->used && r->doorbell)
+        break;
+    if(r == ringtab.ring + NHASHRING){
+      sleep(&ringtab, &ringtab.lock);
+      continue;
+    }
+    r->doorbell = 0;
+    r->busy = 1;
+    release(&ringtab.lock);
+
+    acquiresleep(&r->lock);
+    // the owner may have freed the ring while we waited for it.
+    if(r->sh)
+      hashringdrain(r);
+    releasesleep(&r->lock);
+
+    acquire(&ringtab.lock);
+    r->busy = 0;
+    wakeup(r);
+  }
+}
+
+void
+hashringinit(void)
+{
+  struct hashring *r;
+
+  initlock(&ringtab.lock, "ringtab");
+  for(r = ringtab.ring; r < ringtab.ring + NHASHRING; r++)
+    initsleeplock(&r->lock, "hashring");
+  if(kproc(hashringworker, 0, "hashring") < 0)
+    panic("hashringinit");
+}
+
+// Give the current process a ring, or find the one it has.
+// Returns the ring's user address, or -1.
+uint64
+hashringsetup(void)
+{
+  struct proc *p = myproc();
+  struct hashring *r;
+  char *mem;
+
+  if(p->hashring)
+    return HASHRING;
+
+  acquire(&ringtab.lock);
+  for(r = ringtab.ring; r < ringtab.ring + NHASHRING; r++)
+    if(!r->used)
+      break;
+  if(r == ringtab.ring + NHASHRING){
+    release(&ringtab.lock);
+    return -1;
+  }
+  r->used = 1;
+  r->doorbell = 0;
+  release(&ringtab.lock);
+
+  acquiresleep(&r->lock);
+  if((mem = kalloc()) == 0)
+    goto bad;
+  memset(mem, 0, PGSIZE);
+  if(mappages(p->pagetable, HASHRING, PGSIZE, (uint64)mem, PTE_R | PTE_W | PTE_U) < 0){
+    kfree(mem);
+    goto bad;
+  }
+  r->pagetable = p->pagetable;
+  r->sh = (struct sha256_ring*)mem;
+  releasesleep(&r->lock);
+  p->hashring = r;
+  return HASHRING;
+
+ bad:
+  releasesleep(&r->lock);
+  acquire(&ringtab.lock);
+  r->used = 0;
+  release(&ringtab.lock);
+  return -1;
+}
+
+// Ring the current process's doorbell, then wait until at least
+// want completions are waiting to be reaped, or no more can come.
+// Returns the number waiting, or -1.
+int
+hashringenter(int want)
+{
+  struct proc *p = myproc();
+  struct hashring *r = p->hashring;
+  struct sha256_ring *sh;
+  int ready;
+
+  if(r == 0)
+    return -1;
+  sh = r->sh;
+
+  acquire(&ringtab.lock);
+  r->doorbell = 1;
+  wakeup(&ringtab);
+  for(;;){
+    ready = sh->cq_tail - sh->cq_head;
+    if(ready >= want || ready >= SHA256_RING_CQ)
+      break;
+    if(!r->doorbell && !r->busy)
+      break;                  // drained; the rest waits for another doorbell
+    if(killed(p)){
+      release(&ringtab.lock);
+      return -1;
+    }
+    sleep(r, &ringtab.lock);
+  }
+  release(&ringtab.lock);
+  return ready;
+}
+
+// Free p's ring if it is mapped in pagetable. Called by exit() and,
+// for exec(), by proc_freepagetable() with the old page table.
+void
+hashringfree(struct proc *p, pagetable_t pagetable)
+{
+  struct hashring *r = p->hashring;
+
+  if(r == 0 || r->pagetable != pagetable)
+    return;
+
+  acquiresleep(&r->lock);
+  uvmunmap(pagetable, HASHRING, 1, 1);
+  r->sh = 0;
+  r->pagetable = 0;
+  releasesleep(&r->lock);
+
+  acquire(&ringtab.lock);
+  r->used = 0;
+  r->doorbell = 0;
+  release(&ringtab.lock);
+  p->hashring = 0;
+}
+
+// Keep the worker out of p's page table while p changes it.
+void
+hashringlock(struct proc *p)
+{
+  if(p->hashring)
+    acquiresleep(&p->hashring->lock);
+}
+
+void
+hashringunlock(struct proc *p)
+{
+  if(p->hashring)
+    releasesleep(&p->hashring->lock);
+}
@@ -0,0 +1,47 @@
+// Hashing phase counters.
+//
+// Counts calls, bytes and cycles for each phase of sha256encrypt()
+// (trap, copyin, transform, copyout), so a slow call can be pinned
+// on one of them. Every hart has its own cache-line-aligned counters
+// and is the only one that writes them, with interrupts off, so
+// counting takes no lock. Readers on other harts see each 64-bit
+// counter whole, though not always all of them from the same
+// instant; a reset that races with a hart counting may lose that
+// one update.
+
+#include "types.h"
+#include "param.h"
+#include "riscv.h"
+#include "defs.h"
+#include "sha256.h"
+#include "hashstat.h"
+
+struct {
+  struct sha256_stats st;
+} __attribute__((aligned(64))) hashstat[NCPU];
+
+// Add to the current hart's counters for phase. A sample whose
+// cycles are HASHSTAT_LOST is dropped whole, calls and bytes too.
+void
+hashstat_add(int phase, uint64 calls, uint64 bytes, uint64 cycles)
+{
+  struct sha256_phase *ph;
+
+  if(cycles == HASHSTAT_LOST)
+    return;
+  push_off();
+  ph = &hashstat[cpuid()].st.phase[phase];
+  ph->calls += calls;
+  ph->bytes += bytes;
+  ph->cycles += cycles;
+  pop_off();
+}
+
+// Copy hart's counters into st, then zero them if reset is set.
+void
+hashstat_read(int hart, struct sha256_stats *st, int reset)
+{
+  *st = hashstat[hart].st;
+  if(reset)
+    memset(&hashstat[hart].st, 0, sizeof(hashstat[hart].st));
+}
@@ -0,0 +1,50 @@
+// Per-hart phase counters for sha256encrypt(); see struct
+// sha256_stats in sha256.h.
+
+static inline uint64
+hashstat_now(void)
+{
+  uint64 x;
+  asm volatile("rdcycle %0" : "=r" (x));
+  return x;
+}
+
+// Cycle counters are per hart and not synchronized, so an interval
+// only counts if it starts and ends on the same hart; a process can
+// move to another hart whenever interrupts are on. A mark is a cycle
+// count and the hart it was read on.
+#define HASHSTAT_LOST ((uint64)-1)  // interval spanned two harts
+
+static inline void
+hashstat_mark(uint64 *cycles, int *hart)
+{
+  push_off();
+  *hart = cpuid();
+  *cycles = hashstat_now();
+  pop_off();
+}
+
+// Cycles since the mark, or HASHSTAT_LOST on another hart.
+static inline uint64
+hashstat_since(uint64 cycles, int hart)
+{
+  uint64 x;
+
+  push_off();
+  x = cpuid() == hart ? hashstat_now() - cycles : HASHSTAT_LOST;
+  pop_off();
+  return x;
+}
+
+// *sum += cycles, where either being lost loses the sum.
+static inline void
+hashstat_acc(uint64 *sum, uint64 cycles)
+{
+  if(*sum == HASHSTAT_LOST || cycles == HASHSTAT_LOST)
+    *sum = HASHSTAT_LOST;
+  else
+    *sum += cycles;
+}
+
+void            hashstat_add(int, uint64, uint64, uint64);
+void            hashstat_read(int, struct sha256_stats*, int);
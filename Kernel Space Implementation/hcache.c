@@ -0,0 +1,148 @@
+// File digest cache.
+//
+// Remembers the SHA-256 of whole files, keyed by (dev, inum, gen),
+// so hashing an unchanged file again costs neither disk reads nor
+// compression. ip->gen changes on every writei() and itrunc(), so
+// an entry stops matching as soon as its file is modified.
+//
+// ip->gen lives only in memory and is 0 when an inode is read back
+// from disk. The first modification after that drops the inode's
+// entries, so an entry made under gen 0 can't outlive a write that
+// happened before the inode left the inode table. Later
+// modifications just take a fresh, never reused generation.
+//
+// Like the buffer cache, entries are kept on a list ordered by
+// use, and the least recently used one is replaced.
+
+#include "types.h"
+#include "param.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "riscv.h"
+#include "defs.h"
+#include "fs.h"
+#include "file.h"
+#include "sha256.h"
+
+#define NHCACHE 32
+
+struct hentry {
+  uint dev;
+  uint inum;                // 0 if unused
+  uint64 gen;
+  uchar digest[SHA256_DIGEST_SIZE];
+  struct hentry *prev;      // LRU list
+  struct hentry *next;
+};
+
+struct {
+  struct spinlock lock;
+  struct hentry entry[NHCACHE];
+
+  // Linked list of all entries, through prev/next.
+  // head.next is most recently used, head.prev is least.
+  struct hentry head;
+
+  uint64 gen;               // last generation handed out
+  uint64 hits;
+  uint64 misses;
+} hcache;
+
+void
+hcacheinit(void)
+{
+  struct hentry *e;
+
+  initlock(&hcache.lock, "hcache");
+  hcache.head.prev = &hcache.head;
+  hcache.head.next = &hcache.head;
+  for(e = hcache.entry; e < hcache.entry+NHCACHE; e++){
+    e->next = hcache.head.next;
+    e->prev = &hcache.head;
+    hcache.head.next->prev = e;
+    hcache.head.next = e;
+  }
+}
+
+// Move e to the front of the list. Caller holds hcache.lock.
+static void
+hcachetouch(struct hentry *e)
+{
+  e->next->prev = e->prev;
+  e->prev->next = e->next;
+  e->next = hcache.head.next;
+  e->prev = &hcache.head;
+  hcache.head.next->prev = e;
+  hcache.head.next = e;
+}
+
+// Look up the digest of the whole of ip.
+// Caller must hold ip->lock, so ip->gen can't change.
+// Returns 0 and fills in digest on a hit, -1 on a miss.
+int
+hcacheget(struct inode *ip, uchar *digest)
+{
+  struct hentry *e;
+
+  acquire(&hcache.lock);
+  for(e = hcache.head.next; e != &hcache.head; e = e->next){
+    if(e->inum == ip->inum && e->dev == ip->dev && e->gen == ip->gen){
+      memmove(digest, e->digest, SHA256_DIGEST_SIZE);
+      hcachetouch(e);
+      hcache.hits++;
+      release(&hcache.lock);
+      return 0;
+    }
+  }
+  hcache.misses++;
+  release(&hcache.lock);
+  return -1;
+}
+
+// Remember the digest of the whole of ip, replacing the least
+// recently used entry. Caller must hold ip->lock.
+void
+hcacheput(struct inode *ip, uchar *digest)
+{
+  struct hentry *e;
+
+  acquire(&hcache.lock);
+  e = hcache.head.prev;
+  e->dev = ip->dev;
+  e->inum = ip->inum;
+  e->gen = ip->gen;
+  memmove(e->digest, digest, SHA256_DIGEST_SIZE);
+  hcachetouch(e);
+  release(&hcache.lock);
+}
+
+// ip's data is about to change. Called by writei() and itrunc()
+// with ip->lock held.
+void
+hcachemodified(struct inode *ip)
+{
+  struct hentry *e;
+
+  acquire(&hcache.lock);
+  if(ip->gen == 0){
+    for(e = hcache.head.next; e != &hcache.head; e = e->next)
+      if(e->inum == ip->inum && e->dev == ip->dev)
+        e->inum = 0;
+  }
+  ip->gen = ++hcache.gen;
+  release(&hcache.lock);
+}
+
+// Report hit and miss counts, then zero them if reset is set.
+void
+hcachestats(uint64 *hits, uint64 *misses, int reset)
+{
+  acquire(&hcache.lock);
+  *hits = hcache.hits;
+  *misses = hcache.misses;
+  if(reset){
+    hcache.hits = 0;
+    hcache.misses = 0;
+  }
+  release(&hcache.lock);
+}
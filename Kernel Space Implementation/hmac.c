@@ -0,0 +1,82 @@
+// HMAC-SHA256 key table.
+//
+// sha256hmackey() registers a key once; the table keeps only its
+// inner and outer midstates, never the key itself. sha256hmac()
+// then MACs messages under the key's slot number. xv6 has no
+// users, so any process may use or remove any slot.
+
+#include "types.h"
+#include "param.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "defs.h"
+#include "sha256.h"
+
+#define NHMACKEY 16
+
+struct {
+  struct spinlock lock;
+  struct {
+    int used;
+    struct sha256_hmac_key key;
+  } slot[NHMACKEY];
+} hmactab;
+
+void
+hmacinit(void)
+{
+  initlock(&hmactab.lock, "hmactab");
+}
+
+// Store a prepared key in a free slot.
+// Returns the slot number, or -1 if the table is full.
+int
+hmacadd(struct sha256_hmac_key *key)
+{
+  int i;
+
+  acquire(&hmactab.lock);
+  for(i = 0; i < NHMACKEY; i++){
+    if(!hmactab.slot[i].used){
+      hmactab.slot[i].used = 1;
+      hmactab.slot[i].key = *key;
+      release(&hmactab.lock);
+      return i;
+    }
+  }
+  release(&hmactab.lock);
+  return -1;
+}
+
+// Copy slot id's midstates into key, so that the MAC can be
+// computed without holding the lock.
+int
+hmacget(int id, struct sha256_hmac_key *key)
+{
+  if(id < 0 || id >= NHMACKEY)
+    return -1;
+  acquire(&hmactab.lock);
+  if(!hmactab.slot[id].used){
+    release(&hmactab.lock);
+    return -1;
+  }
+  *key = hmactab.slot[id].key;
+  release(&hmactab.lock);
+  return 0;
+}
+
+int
+hmacdel(int id)
+{
+  if(id < 0 || id >= NHMACKEY)
+    return -1;
+  acquire(&hmactab.lock);
+  if(!hmactab.slot[id].used){
+    release(&hmactab.lock);
+    return -1;
+  }
+  hmactab.slot[id].used = 0;
+  memset(&hmactab.slot[id].key, 0, sizeof(hmactab.slot[id].key));
+  release(&hmactab.lock);
+  return 0;
+}
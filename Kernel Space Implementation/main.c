@@ -3,9 +3,8 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "defs.h"
-
-// Declare sha256_test() function
-void sha256_test(void);
+#include "hashq.h"
+#include "prof.h"
 
 volatile static int started = 0;
 
@@ -19,6 +18,7 @@ main()
     printf("\n");
     printf("xv6 kernel is booting\n");
     printf("\n");
+    sha256_hwinit(dtb); // SHA-256 backend, before kinit() reuses the DTB's memory
     kinit();         // physical page allocator
     kvminit();       // create kernel page table
     kvminithart();   // turn on paging
@@ -31,11 +31,15 @@ main()
     iinit();         // inode table
     fileinit();      // file table
     virtio_disk_init(); // emulated hard disk
-
-// Call the SHA-256 test function
-    sha256_test();
+    hashqinit();     // hashing work queue
+    hmacinit();      // HMAC key table
+    hcacheinit();    // file digest cache
+    profinit();      // sampling profiler
+    hashfileinit();  // hash context files
 
     userinit();      // first user process
+    hashringinit();  // hashing rings and their worker
+    hashqinithart(); // this hart's hashing worker
     __sync_synchronize();
     started = 1;
 
@@ -47,6 +51,7 @@ main()
     kvminithart();    // turn on paging
     trapinithart();   // install kernel trap vector
     plicinithart();   // ask PLIC for device interrupts
+    hashqinithart();  // this hart's hashing worker
   }
 
   scheduler();        
@@ -0,0 +1,203 @@
+// Sampling profiler.
+//
+// While sampling is on, every timer interrupt that finds a hart in
+// the kernel records the interrupted pc (sepc) in that hart's ring.
+// A user program drains the rings with kprof(PROF_READ) and matches
+// the pcs against kernel.sym.
+//
+// One timer interrupt per tick is too coarse to see inside a
+// function, so while sampling the CLINT is asked for
+// PROFRATE interrupts per tick; profintr() tells devintr() which of
+// them end a clock tick, so ticks and preemption keep their pace.
+// A full ring drops new samples rather than old ones, so a long run
+// keeps its beginning and counts what it lost.
+//
+// A timer interrupt that arrives while the hart has interrupts off
+// is taken only when they come back on, so its sample lands where
+// intr_on() or pop_off() turned them on rather than on the code
+// that ran with them off. profintr() notices such a sample by the
+// time since the hart's previous timer interrupt, and sets
+// PROF_LATE in the recorded pc.
+//
+// The timer interrupt takes no lock. Each hart alone writes its own
+// cache-line-aligned ring's head and counters; readers, serialized
+// by prof.lock, only advance tail. When sampling is off the
+// interrupt costs one load of prof.on.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "prof.h"
+
+// start.c: scratch[4] is the hart's interval between timer interrupts.
+extern uint64 timer_scratch[NCPU][5];
+
+struct profring {
+  uint64 pc[PROFNSAMPLE];
+  uint head;                // samples written; written by the hart
+  uint tail;                // samples read; written by readers
+  uint sub;                 // timer interrupts into this tick
+  uint gen;                 // prof.gen when last was taken
+  uint64 last;              // time of the last timer interrupt
+  uint64 dropped;           // written by the hart, never reset
+  uint64 user;
+} __attribute__((aligned(64)));
+
+struct {
+  struct spinlock lock;     // serializes readers, start and stop
+  int on;
+  uint gen;                 // bumped by PROF_START, to restart last
+  uint64 interval;          // timer interval when not sampling
+  uint64 dropped0;          // sums of the rings' counters at PROF_START
+  uint64 user0;
+  struct profring ring[NCPU];
+} prof;
+
+void
+profinit(void)
+{
+  initlock(&prof.lock, "prof");
+  prof.interval = timer_scratch[0][4];
+}
+
+// Called by devintr() on every timer interrupt, with interrupts off
+// and sepc and sstatus still those of the interrupted code.
+// Returns 1 if the interrupt ends a clock tick.
+int
+profintr(void)
+{
+  struct profring *r;
+  uint64 now, pc;
+  uint gen;
+  int id, tick = 1;
+
+  if(__atomic_load_n(&prof.on, __ATOMIC_ACQUIRE) == 0)
+    return 1;
+
+  id = cpuid();
+  r = &prof.ring[id];
+  if(++r->sub < PROFRATE)
+    tick = 0;
+  else
+    r->sub = 0;
+
+  // late if well over one interval since the previous interrupt;
+  // the first one after PROF_START has nothing to compare with.
+  pc = r_sepc();
+  now = r_time();
+  gen = __atomic_load_n(&prof.gen, __ATOMIC_RELAXED);
+  if(r->gen == gen && now - r->last > timer_scratch[id][4] + timer_scratch[id][4] / 4)
+    pc |= PROF_LATE;
+  r->gen = gen;
+  r->last = now;
+
+  if((r_sstatus() & SSTATUS_SPP) == 0){
+    __atomic_store_n(&r->user, r->user + 1, __ATOMIC_RELAXED);
+  } else if(r->head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) == PROFNSAMPLE){
+    __atomic_store_n(&r->dropped, r->dropped + 1, __ATOMIC_RELAXED);
+  } else {
+    r->pc[r->head % PROFNSAMPLE] = pc;
+    __atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);  // publish the sample
+  }
+  return tick;
+}
+
+// Sum one counter over every hart's ring.
+static uint64
+profsum(int user)
+{
+  uint64 v = 0;
+  int i;
+
+  for(i = 0; i < NCPU; i++)
+    v += __atomic_load_n(user ? &prof.ring[i].user : &prof.ring[i].dropped, __ATOMIC_RELAXED);
+  return v;
+}
+
+// Set every hart's timer interval. Each hart picks the new
+// interval up at its next timer interrupt.
+static void
+profinterval(uint64 interval)
+{
+  int i;
+
+  for(i = 0; i < NCPU; i++)
+    timer_scratch[i][4] = interval;
+}
+
+// Move up to n samples, oldest first within each hart, to the
+// user array at addr. Returns the number moved, or -1.
+static int
+profread(uint64 addr, int n)
+{
+  uint64 *buf;
+  uint head;
+  int i, m, total;
+
+  if((buf = (uint64*)kalloc()) == 0)
+    return -1;
+  total = 0;
+  for(i = 0; i < NCPU && total < n; ){
+    acquire(&prof.lock);
+    struct profring *r = &prof.ring[i];
+    head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    for(m = 0; m < PGSIZE/sizeof(uint64) && total + m < n && r->tail + m != head; m++)
+      buf[m] = r->pc[(r->tail + m) % PROFNSAMPLE];
+    __atomic_store_n(&r->tail, r->tail + m, __ATOMIC_RELEASE);  // free the slots
+    if(r->tail == head)
+      i++;
+    release(&prof.lock);
+    if(copyout(myproc()->pagetable, addr + total*sizeof(uint64), (char*)buf, m*sizeof(uint64)) < 0){
+      kfree(buf);
+      return -1;
+    }
+    total += m;
+  }
+  kfree(buf);
+  return total;
+}
+
+int
+profctl(int op, uint64 addr, int n)
+{
+  int i;
+  uint64 v;
+
+  switch(op){
+  case PROF_START:
+    // the harts own head and the counters, so empty the rings
+    // from the reading side and count from the current totals.
+    acquire(&prof.lock);
+    for(i = 0; i < NCPU; i++)
+      __atomic_store_n(&prof.ring[i].tail,
+                       __atomic_load_n(&prof.ring[i].head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    prof.dropped0 = profsum(0);
+    prof.user0 = profsum(1);
+    __atomic_store_n(&prof.gen, prof.gen + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&prof.on, 1, __ATOMIC_RELEASE);
+    profinterval(prof.interval / PROFRATE);
+    release(&prof.lock);
+    return 0;
+  case PROF_STOP:
+    acquire(&prof.lock);
+    __atomic_store_n(&prof.on, 0, __ATOMIC_RELEASE);
+    profinterval(prof.interval);
+    release(&prof.lock);
+    return 0;
+  case PROF_READ:
+    if(n < 0 || (n > 0 && (addr == 0 || addr >= MAXVA)))
+      return -1;
+    return profread(addr, n);
+  case PROF_DROPPED:
+  case PROF_USER:
+    acquire(&prof.lock);
+    v = op == PROF_DROPPED ? profsum(0) - prof.dropped0 : profsum(1) - prof.user0;
+    release(&prof.lock);
+    return v;
+  }
+  return -1;
+}
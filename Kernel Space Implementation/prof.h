@@ -0,0 +1,20 @@
+// Kernel sampling profiler; see prof.c.
+
+// kprof() operations
+#define PROF_START   1  // empty the sample rings and start sampling
+#define PROF_STOP    2  // stop sampling
+#define PROF_READ    3  // move up to n samples into pcs; returns how many
+#define PROF_DROPPED 4  // returns samples lost to full rings since PROF_START
+#define PROF_USER    5  // returns samples that found a hart in user code
+
+// Set in a sample's pc if the timer interrupt was held off by
+// interrupts being disabled; the pc is then where they were turned
+// back on, not where the time went. Kernel pcs are even.
+#define PROF_LATE    1
+
+#define PROFRATE     10    // timer interrupts per clock tick while sampling
+#define PROFNSAMPLE  4096  // samples each hart can hold
+
+void            profinit(void);
+int             profintr(void);
+int             profctl(int, uint64, int);
@@ -0,0 +1,739 @@
+#include "types.h"
+#include "sha256.h"
+
+// SHA-256 core shared by the kernel and the user library.
+// Kept free of kernel and libc calls so the same object links
+// into both.
+
+// Constants for SHA-256
+static const uint K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// Initial hash values (H0, H1, ..., H7)
+static const uint H[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+// Helper function for right rotation
+static uint right_rotate(uint value, unsigned int count) {
+    return (value >> count) | (value << (32 - count));
+}
+
+// SHA-256 transformation (main calculation for each block)
+static void sha256_transform_loop(uint *state, const uchar *block) {
+    uint W[64];
+    uint a, b, c, d, e, f, g, h;
+
+    // Prepare message schedule
+    for (int i = 0; i < 16; ++i) {
+        W[i] = (block[i * 4] << 24) | (block[i * 4 + 1] << 16) |
+               (block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; ++i) {
+        uint s0 = right_rotate(W[i - 15], 7) ^ right_rotate(W[i - 15], 18) ^ (W[i - 15] >> 3);
+        uint s1 = right_rotate(W[i - 2], 17) ^ right_rotate(W[i - 2], 19) ^ (W[i - 2] >> 10);
+        W[i] = W[i - 16] + s0 + W[i - 7] + s1;
+    }
+
+    // Initialize working variables
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    // Main computation loop
+    for (int i = 0; i < 64; ++i) {
+        uint S1 = right_rotate(e, 6) ^ right_rotate(e, 11) ^ right_rotate(e, 25);
+        uint ch = (e & f) ^ (~e & g);
+        uint temp1 = h + S1 + ch + K[i] + W[i];
+        uint S0 = right_rotate(a, 2) ^ right_rotate(a, 13) ^ right_rotate(a, 22);
+        uint maj = (a & b) ^ (a & c) ^ (b & c);
+        uint temp2 = S0 + maj;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    // Add the compressed chunk to the current state
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+// Straightforward loop version of the compression function, one
+// block per iteration with a 64-word schedule. Kept as a reference
+// for testing and benchmarking sha256_blocks.
+void sha256_blocks_loop(uint *state, const uchar *data, uint64 nblocks) {
+    for (; nblocks > 0; nblocks--, data += SHA256_BLOCK_SIZE)
+        sha256_transform_loop(state, data);
+}
+
+// Zknh scalar crypto instructions, encoded with .insn so that the
+// assembler needs no knowledge of the extension. Only executed when
+// the hart reports Zknh.
+#define ZKNH_OP(imm, x) ({ uint r_; \
+        asm(".insn i 0x13, 1, %0, %1, " #imm : "=r" (r_) : "r" (x)); r_; })
+#define ZKNH_SUM0(x)  ZKNH_OP(0x100, x)   // sha256sum0
+#define ZKNH_SUM1(x)  ZKNH_OP(0x101, x)   // sha256sum1
+#define ZKNH_SIG0(x)  ZKNH_OP(0x102, x)   // sha256sig0
+#define ZKNH_SIG1(x)  ZKNH_OP(0x103, x)   // sha256sig1
+
+#define ROTR(x, n)   (((x) >> (n)) | ((x) << (32 - (n))))
+#define BSIG0(x)     (zknh ? ZKNH_SUM0(x) : ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define BSIG1(x)     (zknh ? ZKNH_SUM1(x) : ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define SSIG0(x)     (zknh ? ZKNH_SIG0(x) : ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define SSIG1(x)     (zknh ? ZKNH_SIG1(x) : ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+#define CH(x, y, z)  ((z) ^ ((x) & ((y) ^ (z))))
+#define MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+
+// Message word i < 16 of schedule w, read big-endian from block p
+#define LOAD_(w, p, i) (w[i] = ((uint)(p)[(i) * 4] << 24) | ((uint)(p)[(i) * 4 + 1] << 16) | \
+                               ((uint)(p)[(i) * 4 + 2] << 8) | (p)[(i) * 4 + 3])
+
+// Message word i >= 16, computed in place over word i - 16 of the
+// 16-word rolling window
+#define SCHED_(w, p, i) (w[(i) & 15] += SSIG1(w[((i) - 2) & 15]) + w[((i) - 7) & 15] + \
+                                        SSIG0(w[((i) - 15) & 15]))
+
+#define LOAD(i)  LOAD_(w, data, i)
+#define SCHED(i) SCHED_(w, data, i)
+
+// One round. Instead of shuffling eight variables, each round
+// names them in rotated order; only d and h are written.
+#define ROUND(a, b, c, d, e, f, g, h, k, wi) do {      \
+        uint t1 = (h) + BSIG1(e) + CH(e, f, g) + (k) + (wi); \
+        (d) += t1;                                       \
+        (h) = t1 + BSIG0(a) + MAJ(a, b, c);              \
+    } while (0)
+
+// The same round of two independent messages, whose working
+// variables are named with suffixes 0 and 1. Neither depends on the
+// other, so the compiler can issue them side by side.
+#define ROUND2(a, b, c, d, e, f, g, h, k, i, M) do {                       \
+        ROUND(a##0, b##0, c##0, d##0, e##0, f##0, g##0, h##0, k, M(w0, data0, i)); \
+        ROUND(a##1, b##1, c##1, d##1, e##1, f##1, g##1, h##1, k, M(w1, data1, i)); \
+    } while (0)
+
+// Compress nblocks consecutive 64-byte blocks into state. All 64
+// rounds are unrolled with the round constants as immediates, and
+// the working variables stay in registers from block to block.
+// Inlined into each backend with zknh constant, so only one set of
+// sigma functions is compiled into each.
+static inline __attribute__((always_inline))
+void sha256_blocks_unrolled(uint *state, const uchar *data, uint64 nblocks, const int zknh) {
+    uint a = state[0], b = state[1], c = state[2], d = state[3];
+    uint e = state[4], f = state[5], g = state[6], h = state[7];
+    uint w[16];
+
+    for (; nblocks > 0; nblocks--, data += SHA256_BLOCK_SIZE) {
+        ROUND(a, b, c, d, e, f, g, h, 0x428a2f98, LOAD(0));
+        ROUND(h, a, b, c, d, e, f, g, 0x71374491, LOAD(1));
+        ROUND(g, h, a, b, c, d, e, f, 0xb5c0fbcf, LOAD(2));
+        ROUND(f, g, h, a, b, c, d, e, 0xe9b5dba5, LOAD(3));
+        ROUND(e, f, g, h, a, b, c, d, 0x3956c25b, LOAD(4));
+        ROUND(d, e, f, g, h, a, b, c, 0x59f111f1, LOAD(5));
+        ROUND(c, d, e, f, g, h, a, b, 0x923f82a4, LOAD(6));
+        ROUND(b, c, d, e, f, g, h, a, 0xab1c5ed5, LOAD(7));
+        ROUND(a, b, c, d, e, f, g, h, 0xd807aa98, LOAD(8));
+        ROUND(h, a, b, c, d, e, f, g, 0x12835b01, LOAD(9));
+        ROUND(g, h, a, b, c, d, e, f, 0x243185be, LOAD(10));
+        ROUND(f, g, h, a, b, c, d, e, 0x550c7dc3, LOAD(11));
+        ROUND(e, f, g, h, a, b, c, d, 0x72be5d74, LOAD(12));
+        ROUND(d, e, f, g, h, a, b, c, 0x80deb1fe, LOAD(13));
+        ROUND(c, d, e, f, g, h, a, b, 0x9bdc06a7, LOAD(14));
+        ROUND(b, c, d, e, f, g, h, a, 0xc19bf174, LOAD(15));
+        ROUND(a, b, c, d, e, f, g, h, 0xe49b69c1, SCHED(16));
+        ROUND(h, a, b, c, d, e, f, g, 0xefbe4786, SCHED(17));
+        ROUND(g, h, a, b, c, d, e, f, 0x0fc19dc6, SCHED(18));
+        ROUND(f, g, h, a, b, c, d, e, 0x240ca1cc, SCHED(19));
+        ROUND(e, f, g, h, a, b, c, d, 0x2de92c6f, SCHED(20));
+        ROUND(d, e, f, g, h, a, b, c, 0x4a7484aa, SCHED(21));
+        ROUND(c, d, e, f, g, h, a, b, 0x5cb0a9dc, SCHED(22));
+        ROUND(b, c, d, e, f, g, h, a, 0x76f988da, SCHED(23));
+        ROUND(a, b, c, d, e, f, g, h, 0x983e5152, SCHED(24));
+        ROUND(h, a, b, c, d, e, f, g, 0xa831c66d, SCHED(25));
+        ROUND(g, h, a, b, c, d, e, f, 0xb00327c8, SCHED(26));
+        ROUND(f, g, h, a, b, c, d, e, 0xbf597fc7, SCHED(27));
+        ROUND(e, f, g, h, a, b, c, d, 0xc6e00bf3, SCHED(28));
+        ROUND(d, e, f, g, h, a, b, c, 0xd5a79147, SCHED(29));
+        ROUND(c, d, e, f, g, h, a, b, 0x06ca6351, SCHED(30));
+        ROUND(b, c, d, e, f, g, h, a, 0x14292967, SCHED(31));
+        ROUND(a, b, c, d, e, f, g, h, 0x27b70a85, SCHED(32));
+        ROUND(h, a, b, c, d, e, f, g, 0x2e1b2138, SCHED(33));
+        ROUND(g, h, a, b, c, d, e, f, 0x4d2c6dfc, SCHED(34));
+        ROUND(f, g, h, a, b, c, d, e, 0x53380d13, SCHED(35));
+        ROUND(e, f, g, h, a, b, c, d, 0x650a7354, SCHED(36));
+        ROUND(d, e, f, g, h, a, b, c, 0x766a0abb, SCHED(37));
+        ROUND(c, d, e, f, g, h, a, b, 0x81c2c92e, SCHED(38));
+        ROUND(b, c, d, e, f, g, h, a, 0x92722c85, SCHED(39));
+        ROUND(a, b, c, d, e, f, g, h, 0xa2bfe8a1, SCHED(40));
+        ROUND(h, a, b, c, d, e, f, g, 0xa81a664b, SCHED(41));
+        ROUND(g, h, a, b, c, d, e, f, 0xc24b8b70, SCHED(42));
+        ROUND(f, g, h, a, b, c, d, e, 0xc76c51a3, SCHED(43));
+        ROUND(e, f, g, h, a, b, c, d, 0xd192e819, SCHED(44));
+        ROUND(d, e, f, g, h, a, b, c, 0xd6990624, SCHED(45));
+        ROUND(c, d, e, f, g, h, a, b, 0xf40e3585, SCHED(46));
+        ROUND(b, c, d, e, f, g, h, a, 0x106aa070, SCHED(47));
+        ROUND(a, b, c, d, e, f, g, h, 0x19a4c116, SCHED(48));
+        ROUND(h, a, b, c, d, e, f, g, 0x1e376c08, SCHED(49));
+        ROUND(g, h, a, b, c, d, e, f, 0x2748774c, SCHED(50));
+        ROUND(f, g, h, a, b, c, d, e, 0x34b0bcb5, SCHED(51));
+        ROUND(e, f, g, h, a, b, c, d, 0x391c0cb3, SCHED(52));
+        ROUND(d, e, f, g, h, a, b, c, 0x4ed8aa4a, SCHED(53));
+        ROUND(c, d, e, f, g, h, a, b, 0x5b9cca4f, SCHED(54));
+        ROUND(b, c, d, e, f, g, h, a, 0x682e6ff3, SCHED(55));
+        ROUND(a, b, c, d, e, f, g, h, 0x748f82ee, SCHED(56));
+        ROUND(h, a, b, c, d, e, f, g, 0x78a5636f, SCHED(57));
+        ROUND(g, h, a, b, c, d, e, f, 0x84c87814, SCHED(58));
+        ROUND(f, g, h, a, b, c, d, e, 0x8cc70208, SCHED(59));
+        ROUND(e, f, g, h, a, b, c, d, 0x90befffa, SCHED(60));
+        ROUND(d, e, f, g, h, a, b, c, 0xa4506ceb, SCHED(61));
+        ROUND(c, d, e, f, g, h, a, b, 0xbef9a3f7, SCHED(62));
+        ROUND(b, c, d, e, f, g, h, a, 0xc67178f2, SCHED(63));
+
+        a = state[0] += a;
+        b = state[1] += b;
+        c = state[2] += c;
+        d = state[3] += d;
+        e = state[4] += e;
+        f = state[5] += f;
+        g = state[6] += g;
+        h = state[7] += h;
+    }
+}
+
+// Compress nblocks blocks of two messages at once, interleaving
+// their rounds. One message's rounds form a single dependency chain
+// through a..h, which leaves most of a superscalar hart idle; two
+// chains keep more of its issue slots busy.
+static inline __attribute__((always_inline))
+void sha256_blocks_x2_unrolled(uint *state0, uint *state1, const uchar *data0,
+                               const uchar *data1, uint64 nblocks, const int zknh) {
+    uint a0 = state0[0], b0 = state0[1], c0 = state0[2], d0 = state0[3];
+    uint e0 = state0[4], f0 = state0[5], g0 = state0[6], h0 = state0[7];
+    uint a1 = state1[0], b1 = state1[1], c1 = state1[2], d1 = state1[3];
+    uint e1 = state1[4], f1 = state1[5], g1 = state1[6], h1 = state1[7];
+    uint w0[16], w1[16];
+
+    for (; nblocks > 0; nblocks--, data0 += SHA256_BLOCK_SIZE, data1 += SHA256_BLOCK_SIZE) {
+        ROUND2(a, b, c, d, e, f, g, h, 0x428a2f98, 0, LOAD_);
+        ROUND2(h, a, b, c, d, e, f, g, 0x71374491, 1, LOAD_);
+        ROUND2(g, h, a, b, c, d, e, f, 0xb5c0fbcf, 2, LOAD_);
+        ROUND2(f, g, h, a, b, c, d, e, 0xe9b5dba5, 3, LOAD_);
+        ROUND2(e, f, g, h, a, b, c, d, 0x3956c25b, 4, LOAD_);
+        ROUND2(d, e, f, g, h, a, b, c, 0x59f111f1, 5, LOAD_);
+        ROUND2(c, d, e, f, g, h, a, b, 0x923f82a4, 6, LOAD_);
+        ROUND2(b, c, d, e, f, g, h, a, 0xab1c5ed5, 7, LOAD_);
+        ROUND2(a, b, c, d, e, f, g, h, 0xd807aa98, 8, LOAD_);
+        ROUND2(h, a, b, c, d, e, f, g, 0x12835b01, 9, LOAD_);
+        ROUND2(g, h, a, b, c, d, e, f, 0x243185be, 10, LOAD_);
+        ROUND2(f, g, h, a, b, c, d, e, 0x550c7dc3, 11, LOAD_);
+        ROUND2(e, f, g, h, a, b, c, d, 0x72be5d74, 12, LOAD_);
+        ROUND2(d, e, f, g, h, a, b, c, 0x80deb1fe, 13, LOAD_);
+        ROUND2(c, d, e, f, g, h, a, b, 0x9bdc06a7, 14, LOAD_);
+        ROUND2(b, c, d, e, f, g, h, a, 0xc19bf174, 15, LOAD_);
+        ROUND2(a, b, c, d, e, f, g, h, 0xe49b69c1, 16, SCHED_);
+        ROUND2(h, a, b, c, d, e, f, g, 0xefbe4786, 17, SCHED_);
+        ROUND2(g, h, a, b, c, d, e, f, 0x0fc19dc6, 18, SCHED_);
+        ROUND2(f, g, h, a, b, c, d, e, 0x240ca1cc, 19, SCHED_);
+        ROUND2(e, f, g, h, a, b, c, d, 0x2de92c6f, 20, SCHED_);
+        ROUND2(d, e, f, g, h, a, b, c, 0x4a7484aa, 21, SCHED_);
+        ROUND2(c, d, e, f, g, h, a, b, 0x5cb0a9dc, 22, SCHED_);
+        ROUND2(b, c, d, e, f, g, h, a, 0x76f988da, 23, SCHED_);
+        ROUND2(a, b, c, d, e, f, g, h, 0x983e5152, 24, SCHED_);
+        ROUND2(h, a, b, c, d, e, f, g, 0xa831c66d, 25, SCHED_);
+        ROUND2(g, h, a, b, c, d, e, f, 0xb00327c8, 26, SCHED_);
+        ROUND2(f, g, h, a, b, c, d, e, 0xbf597fc7, 27, SCHED_);
+        ROUND2(e, f, g, h, a, b, c, d, 0xc6e00bf3, 28, SCHED_);
+        ROUND2(d, e, f, g, h, a, b, c, 0xd5a79147, 29, SCHED_);
+        ROUND2(c, d, e, f, g, h, a, b, 0x06ca6351, 30, SCHED_);
+        ROUND2(b, c, d, e, f, g, h, a, 0x14292967, 31, SCHED_);
+        ROUND2(a, b, c, d, e, f, g, h, 0x27b70a85, 32, SCHED_);
+        ROUND2(h, a, b, c, d, e, f, g, 0x2e1b2138, 33, SCHED_);
+        ROUND2(g, h, a, b, c, d, e, f, 0x4d2c6dfc, 34, SCHED_);
+        ROUND2(f, g, h, a, b, c, d, e, 0x53380d13, 35, SCHED_);
+        ROUND2(e, f, g, h, a, b, c, d, 0x650a7354, 36, SCHED_);
+        ROUND2(d, e, f, g, h, a, b, c, 0x766a0abb, 37, SCHED_);
+        ROUND2(c, d, e, f, g, h, a, b, 0x81c2c92e, 38, SCHED_);
+        ROUND2(b, c, d, e, f, g, h, a, 0x92722c85, 39, SCHED_);
+        ROUND2(a, b, c, d, e, f, g, h, 0xa2bfe8a1, 40, SCHED_);
+        ROUND2(h, a, b, c, d, e, f, g, 0xa81a664b, 41, SCHED_);
+        ROUND2(g, h, a, b, c, d, e, f, 0xc24b8b70, 42, SCHED_);
+        ROUND2(f, g, h, a, b, c, d, e, 0xc76c51a3, 43, SCHED_);
+        ROUND2(e, f, g, h, a, b, c, d, 0xd192e819, 44, SCHED_);
+        ROUND2(d, e, f, g, h, a, b, c, 0xd6990624, 45, SCHED_);
+        ROUND2(c, d, e, f, g, h, a, b, 0xf40e3585, 46, SCHED_);
+        ROUND2(b, c, d, e, f, g, h, a, 0x106aa070, 47, SCHED_);
+        ROUND2(a, b, c, d, e, f, g, h, 0x19a4c116, 48, SCHED_);
+        ROUND2(h, a, b, c, d, e, f, g, 0x1e376c08, 49, SCHED_);
+        ROUND2(g, h, a, b, c, d, e, f, 0x2748774c, 50, SCHED_);
+        ROUND2(f, g, h, a, b, c, d, e, 0x34b0bcb5, 51, SCHED_);
+        ROUND2(e, f, g, h, a, b, c, d, 0x391c0cb3, 52, SCHED_);
+        ROUND2(d, e, f, g, h, a, b, c, 0x4ed8aa4a, 53, SCHED_);
+        ROUND2(c, d, e, f, g, h, a, b, 0x5b9cca4f, 54, SCHED_);
+        ROUND2(b, c, d, e, f, g, h, a, 0x682e6ff3, 55, SCHED_);
+        ROUND2(a, b, c, d, e, f, g, h, 0x748f82ee, 56, SCHED_);
+        ROUND2(h, a, b, c, d, e, f, g, 0x78a5636f, 57, SCHED_);
+        ROUND2(g, h, a, b, c, d, e, f, 0x84c87814, 58, SCHED_);
+        ROUND2(f, g, h, a, b, c, d, e, 0x8cc70208, 59, SCHED_);
+        ROUND2(e, f, g, h, a, b, c, d, 0x90befffa, 60, SCHED_);
+        ROUND2(d, e, f, g, h, a, b, c, 0xa4506ceb, 61, SCHED_);
+        ROUND2(c, d, e, f, g, h, a, b, 0xbef9a3f7, 62, SCHED_);
+        ROUND2(b, c, d, e, f, g, h, a, 0xc67178f2, 63, SCHED_);
+
+        a0 = state0[0] += a0;
+        b0 = state0[1] += b0;
+        c0 = state0[2] += c0;
+        d0 = state0[3] += d0;
+        e0 = state0[4] += e0;
+        f0 = state0[5] += f0;
+        g0 = state0[6] += g0;
+        h0 = state0[7] += h0;
+        a1 = state1[0] += a1;
+        b1 = state1[1] += b1;
+        c1 = state1[2] += c1;
+        d1 = state1[3] += d1;
+        e1 = state1[4] += e1;
+        f1 = state1[5] += f1;
+        g1 = state1[6] += g1;
+        h1 = state1[7] += h1;
+    }
+}
+
+void sha256_blocks_generic(uint *state, const uchar *data, uint64 nblocks) {
+    sha256_blocks_unrolled(state, data, nblocks, 0);
+}
+
+void sha256_blocks_zknh(uint *state, const uchar *data, uint64 nblocks) {
+    sha256_blocks_unrolled(state, data, nblocks, 1);
+}
+
+void sha256_blocks_x2_generic(uint *state0, uint *state1, const uchar *data0,
+                              const uchar *data1, uint64 nblocks) {
+    sha256_blocks_x2_unrolled(state0, state1, data0, data1, nblocks, 0);
+}
+
+void sha256_blocks_x2_zknh(uint *state0, uint *state1, const uchar *data0,
+                           const uchar *data1, uint64 nblocks) {
+    sha256_blocks_x2_unrolled(state0, state1, data0, data1, nblocks, 1);
+}
+
+static void sha256_blocks_probe(uint *state, const uchar *data, uint64 nblocks);
+static void sha256_blocks_x2_probe(uint *state0, uint *state1, const uchar *data0,
+                                   const uchar *data1, uint64 nblocks);
+
+// Backends in use; picked from sha256caps() on first use.
+static void (*blocks_impl)(uint *state, const uchar *data, uint64 nblocks) = sha256_blocks_probe;
+static void (*blocks_x2_impl)(uint *state0, uint *state1, const uchar *data0,
+                              const uchar *data1, uint64 nblocks) = sha256_blocks_x2_probe;
+
+// Use the fastest backend the given SHA256_CAP_* features allow.
+void sha256_select(int caps) {
+    if (caps & SHA256_CAP_ZKNH) {
+        blocks_impl = sha256_blocks_zknh;
+        blocks_x2_impl = sha256_blocks_x2_zknh;
+    } else {
+        blocks_impl = sha256_blocks_generic;
+        blocks_x2_impl = sha256_blocks_x2_generic;
+    }
+}
+
+static void sha256_blocks_probe(uint *state, const uchar *data, uint64 nblocks) {
+    sha256_select(sha256caps());
+    blocks_impl(state, data, nblocks);
+}
+
+static void sha256_blocks_x2_probe(uint *state0, uint *state1, const uchar *data0,
+                                   const uchar *data1, uint64 nblocks) {
+    sha256_select(sha256caps());
+    blocks_x2_impl(state0, state1, data0, data1, nblocks);
+}
+
+void sha256_blocks(uint *state, const uchar *data, uint64 nblocks) {
+    blocks_impl(state, data, nblocks);
+}
+
+void sha256_blocks_x2(uint *state0, uint *state1, const uchar *data0,
+                      const uchar *data1, uint64 nblocks) {
+    blocks_x2_impl(state0, state1, data0, data1, nblocks);
+}
+
+// Compress one 64-byte block into state.
+void sha256_transform(uint *state, const uchar *block) {
+    sha256_blocks(state, block, 1);
+}
+
+// Store state as a big-endian digest.
+static void sha256_store(const uint *state, uchar *output) {
+    for (int i = 0; i < 8; ++i) {
+        output[i * 4] = (state[i] >> 24) & 0xff;
+        output[i * 4 + 1] = (state[i] >> 16) & 0xff;
+        output[i * 4 + 2] = (state[i] >> 8) & 0xff;
+        output[i * 4 + 3] = state[i] & 0xff;
+    }
+}
+
+void sha256_init(struct sha256_ctx *ctx) {
+    for (int i = 0; i < 8; ++i) ctx->state[i] = H[i];
+    ctx->len = 0;
+}
+
+void sha256_update(struct sha256_ctx *ctx, const uchar *data, uint len) {
+    uint used = ctx->len % SHA256_BLOCK_SIZE;
+    uint i;
+
+    ctx->len += len;
+
+    // Top up a partially filled block first
+    if (used > 0) {
+        uint n = SHA256_BLOCK_SIZE - used;
+        if (n > len) n = len;
+        for (i = 0; i < n; ++i) ctx->buf[used + i] = data[i];
+        data += n;
+        len -= n;
+        if (used + n < SHA256_BLOCK_SIZE) return;
+        sha256_transform(ctx->state, ctx->buf);
+    }
+
+    // Whole blocks are compressed straight from the caller's buffer
+    if (len >= SHA256_BLOCK_SIZE) {
+        sha256_blocks(ctx->state, data, len / SHA256_BLOCK_SIZE);
+        data += len - len % SHA256_BLOCK_SIZE;
+        len %= SHA256_BLOCK_SIZE;
+    }
+
+    // Keep the tail for the next update or for sha256_final
+    for (i = 0; i < len; ++i) ctx->buf[i] = data[i];
+}
+
+void sha256_final(struct sha256_ctx *ctx, uchar *output) {
+    uint j = ctx->len % SHA256_BLOCK_SIZE;
+    uint64 bit_len = ctx->len * 8;
+    int i;
+
+    // Handle padding for the last block
+    ctx->buf[j++] = 0x80;
+    if (j > 56) {
+        while (j < 64) ctx->buf[j++] = 0;
+        sha256_transform(ctx->state, ctx->buf);
+        j = 0;
+    }
+    while (j < 56) ctx->buf[j++] = 0;
+    for (i = 0; i < 8; ++i) ctx->buf[63 - i] = (bit_len >> (i * 8)) & 0xff;
+    sha256_transform(ctx->state, ctx->buf);
+
+    // Output the final hash
+    sha256_store(ctx->state, output);
+}
+
+void sha256(const uchar *input, uint len, uchar *output) {
+    struct sha256_ctx ctx;
+
+    sha256_init(&ctx);
+    sha256_update(&ctx, input, len);
+    sha256_final(&ctx, output);
+}
+
+// Keys longer than a block are hashed first; shorter ones are
+// padded with zeros.
+void sha256_hmac_setkey(struct sha256_hmac_key *key, const uchar *k, uint klen) {
+    uchar block[SHA256_BLOCK_SIZE];
+    uchar digest[SHA256_DIGEST_SIZE];
+    int i;
+
+    if (klen > SHA256_BLOCK_SIZE) {
+        sha256(k, klen, digest);
+        k = digest;
+        klen = SHA256_DIGEST_SIZE;
+    }
+
+    for (i = 0; i < SHA256_BLOCK_SIZE; ++i)
+        block[i] = (i < klen ? k[i] : 0) ^ 0x36;
+    for (i = 0; i < 8; ++i) key->inner[i] = H[i];
+    sha256_transform(key->inner, block);
+
+    for (i = 0; i < SHA256_BLOCK_SIZE; ++i)
+        block[i] ^= 0x36 ^ 0x5c;
+    for (i = 0; i < 8; ++i) key->outer[i] = H[i];
+    sha256_transform(key->outer, block);
+
+    // Don't leave key material on the stack
+    for (i = 0; i < SHA256_BLOCK_SIZE; ++i) block[i] = 0;
+    for (i = 0; i < SHA256_DIGEST_SIZE; ++i) digest[i] = 0;
+}
+
+// Start an inner hash as if the ipad block had just been hashed.
+void sha256_hmac_init(struct sha256_ctx *ctx, const struct sha256_hmac_key *key) {
+    for (int i = 0; i < 8; ++i) ctx->state[i] = key->inner[i];
+    ctx->len = SHA256_BLOCK_SIZE;
+}
+
+// Finish the inner hash, then hash its digest from the outer
+// midstate: one more block.
+void sha256_hmac_final(struct sha256_ctx *ctx, const struct sha256_hmac_key *key, uchar *mac) {
+    uchar inner[SHA256_DIGEST_SIZE];
+
+    sha256_final(ctx, inner);
+    for (int i = 0; i < 8; ++i) ctx->state[i] = key->outer[i];
+    ctx->len = SHA256_BLOCK_SIZE;
+    sha256_update(ctx, inner, SHA256_DIGEST_SIZE);
+    sha256_final(ctx, mac);
+}
+
+void sha256_hmac(const struct sha256_hmac_key *key, const uchar *input, uint len, uchar *mac) {
+    struct sha256_ctx ctx;
+
+    sha256_hmac_init(&ctx, key);
+    sha256_update(&ctx, input, len);
+    sha256_hmac_final(&ctx, key, mac);
+}
+
+void sha256_pbkdf2_block(const struct sha256_hmac_key *key, const uchar *salt, uint saltlen,
+                         uint iterations, uint index, uchar *output) {
+    struct sha256_ctx ctx;
+    uchar be_index[4] = { index >> 24, index >> 16, index >> 8, index };
+    uchar block[SHA256_BLOCK_SIZE];
+    uint u[8], t[8];
+    int i;
+
+    // U1 = HMAC(P, S || INT(index))
+    sha256_hmac_init(&ctx, key);
+    sha256_update(&ctx, salt, saltlen);
+    sha256_update(&ctx, be_index, 4);
+    sha256_hmac_final(&ctx, key, block);
+    for (i = 0; i < 8; ++i)
+        t[i] = ((uint)block[i * 4] << 24) | ((uint)block[i * 4 + 1] << 16) |
+               ((uint)block[i * 4 + 2] << 8) | block[i * 4 + 3];
+
+    // Each later U MACs the 32-byte previous U. After the key's
+    // midstate, both the inner and the outer hash are then exactly
+    // one block: a digest padded to a total of 64 + 32 bytes. The
+    // padding never changes, so it is written once and each
+    // iteration is just two compressions.
+    block[32] = 0x80;
+    for (i = 33; i < 62; ++i) block[i] = 0;
+    block[62] = ((SHA256_BLOCK_SIZE + SHA256_DIGEST_SIZE) * 8) >> 8;
+    block[63] = ((SHA256_BLOCK_SIZE + SHA256_DIGEST_SIZE) * 8) & 0xff;
+
+    for (uint n = 1; n < iterations; ++n) {
+        for (i = 0; i < 8; ++i) u[i] = key->inner[i];
+        sha256_transform(u, block);
+        sha256_store(u, block);
+        for (i = 0; i < 8; ++i) u[i] = key->outer[i];
+        sha256_transform(u, block);
+        sha256_store(u, block);
+        for (i = 0; i < 8; ++i) t[i] ^= u[i];
+    }
+    sha256_store(t, output);
+}
+
+void sha256_pbkdf2(const uchar *password, uint passlen, const uchar *salt, uint saltlen,
+                   uint iterations, uchar *output, uint outlen) {
+    struct sha256_hmac_key key;
+    uchar t[SHA256_DIGEST_SIZE];
+    uint index, n, i;
+
+    sha256_hmac_setkey(&key, password, passlen);
+    for (index = 1; outlen > 0; ++index) {
+        sha256_pbkdf2_block(&key, salt, saltlen, iterations, index, t);
+        n = outlen < SHA256_DIGEST_SIZE ? outlen : SHA256_DIGEST_SIZE;
+        for (i = 0; i < n; ++i) output[i] = t[i];
+        output += n;
+        outlen -= n;
+    }
+}
+
+// Start a leaf hash: SHA-256 of 0x00 followed by the leaf bytes.
+void sha256_leaf_init(struct sha256_ctx *ctx) {
+    uchar prefix = 0x00;
+
+    sha256_init(ctx);
+    sha256_update(ctx, &prefix, 1);
+}
+
+// Interior node hash: SHA-256 of 0x01 || left || right.
+static void sha256_tree_node(const uchar *left, const uchar *right, uchar *output) {
+    struct sha256_ctx ctx;
+    uchar prefix = 0x01;
+
+    sha256_init(&ctx);
+    sha256_update(&ctx, &prefix, 1);
+    sha256_update(&ctx, left, SHA256_DIGEST_SIZE);
+    sha256_update(&ctx, right, SHA256_DIGEST_SIZE);
+    sha256_final(&ctx, output);
+}
+
+void sha256_tree_init(struct sha256_tree *tree) {
+    tree->depth = 0;
+    tree->nleaves = 0;
+}
+
+// Add the next leaf hash. Each trailing zero bit in the new leaf
+// count means two equal-sized subtrees on top of the stack are now
+// siblings and can be merged.
+void sha256_tree_add(struct sha256_tree *tree, const uchar *leaf_hash) {
+    uint64 n;
+    int i;
+
+    for (i = 0; i < SHA256_DIGEST_SIZE; ++i)
+        tree->stack[tree->depth][i] = leaf_hash[i];
+    tree->depth++;
+    tree->nleaves++;
+
+    for (n = tree->nleaves; (n & 1) == 0; n >>= 1) {
+        tree->depth--;
+        sha256_tree_node(tree->stack[tree->depth - 1], tree->stack[tree->depth],
+                         tree->stack[tree->depth - 1]);
+    }
+}
+
+// Fold the remaining subtrees, smallest (rightmost) first. This
+// gives the same root as splitting at the largest power of two.
+void sha256_tree_final(struct sha256_tree *tree, uchar *output) {
+    uchar root[SHA256_DIGEST_SIZE];
+    struct sha256_ctx ctx;
+    int i;
+
+    if (tree->depth == 0) {
+        // No leaves at all: hash a single empty leaf
+        sha256_leaf_init(&ctx);
+        sha256_final(&ctx, root);
+    } else {
+        for (i = 0; i < SHA256_DIGEST_SIZE; ++i)
+            root[i] = tree->stack[tree->depth - 1][i];
+        for (int d = tree->depth - 2; d >= 0; --d)
+            sha256_tree_node(tree->stack[d], root, root);
+    }
+    for (i = 0; i < SHA256_DIGEST_SIZE; ++i)
+        output[i] = root[i];
+}
+
+void sha256_tree(const uchar *input, uint len, uchar *output) {
+    struct sha256_tree tree;
+    struct sha256_ctx ctx;
+    uchar leaf[SHA256_DIGEST_SIZE];
+    uint off, n;
+
+    sha256_tree_init(&tree);
+    for (off = 0; off < len; off += n) {
+        n = len - off;
+        if (n > SHA256_TREE_LEAF)
+            n = SHA256_TREE_LEAF;
+        sha256_leaf_init(&ctx);
+        sha256_update(&ctx, input + off, n);
+        sha256_final(&ctx, leaf);
+        sha256_tree_add(&tree, leaf);
+    }
+    sha256_tree_final(&tree, output);
+}
+
+// Portable multi-buffer backend: the lanes two at a time with their
+// rounds interleaved, and an odd last lane on its own.
+void sha256_multi_blocks_generic(uint *state, const uchar *data, uint64 stride, uint64 nblocks, int lanes) {
+    int l;
+
+    for (l = 0; l + 1 < lanes; l += 2)
+        sha256_blocks_x2(state + 8 * l, state + 8 * (l + 1), data + l * stride,
+                         data + (l + 1) * stride, nblocks);
+    if (l < lanes)
+        sha256_blocks(state + 8 * l, data + l * stride, nblocks);
+}
+
+// Multi-buffer backend in use; the kernel installs a vector one at
+// boot when the hart has RVV.
+static sha256_multi_fn multi_impl = sha256_multi_blocks_generic;
+static int multi_lanes = 8;
+
+void sha256_select_multi(sha256_multi_fn fn) {
+    multi_impl = fn;
+}
+
+void sha256_multi_blocks(uint *state, const uchar *data, uint64 stride, uint64 nblocks, int lanes) {
+    multi_impl(state, data, stride, nblocks, lanes);
+}
+
+int sha256_multi_lanes(int lanes) {
+    if (lanes > SHA256_MAXLANES)
+        lanes = SHA256_MAXLANES;
+    if (lanes > 0)
+        multi_lanes = lanes;
+    return multi_lanes;
+}
+
+// Padded tails sha256_multi builds at once; bounds its stack use
+#define MULTI_TAILS 4
+
+void sha256_multi(const uchar *data, uint64 stride, uint len, int n, uchar *output) {
+    uint state[SHA256_MAXLANES][8];
+    uchar tail[MULTI_TAILS][2 * SHA256_BLOCK_SIZE] __attribute__((aligned(8)));
+    uint64 full = len / SHA256_BLOCK_SIZE;
+    uint64 bit_len = (uint64)len * 8;
+    uint rem = len % SHA256_BLOCK_SIZE;
+    uint end = (rem < 56 ? 1 : 2) * SHA256_BLOCK_SIZE;
+    int g, m, t, k, l, i;
+    uint j;
+
+    for (g = 0; g < n; g += m) {
+        m = n - g;
+        if (m > multi_lanes)
+            m = multi_lanes;
+        for (l = 0; l < m; ++l)
+            for (i = 0; i < 8; ++i) state[l][i] = H[i];
+
+        // Whole blocks are compressed straight from the messages
+        if (full > 0)
+            multi_impl(state[0], data + g * stride, stride, full, m);
+
+        // Then the padded last block or two, a few messages at a time
+        for (t = 0; t < m; t += k) {
+            k = m - t;
+            if (k > MULTI_TAILS)
+                k = MULTI_TAILS;
+            for (l = 0; l < k; ++l) {
+                const uchar *p = data + (g + t + l) * stride + full * SHA256_BLOCK_SIZE;
+                uchar *q = tail[l];
+
+                for (j = 0; j < rem; ++j) q[j] = p[j];
+                q[j++] = 0x80;
+                while (j < end - 8) q[j++] = 0;
+                for (i = 0; i < 8; ++i) q[end - 1 - i] = (bit_len >> (i * 8)) & 0xff;
+            }
+            multi_impl(state[t], tail[0], sizeof(tail[0]), end / SHA256_BLOCK_SIZE, k);
+        }
+
+        for (l = 0; l < m; ++l)
+            sha256_store(state[l], output + (g + l) * SHA256_DIGEST_SIZE);
+    }
+}
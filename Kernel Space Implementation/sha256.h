@@ -0,0 +1,222 @@
+// SHA-256, shared by the kernel and user programs.
+// Include after types.h.
+
+#define SHA256_BLOCK_SIZE  64
+#define SHA256_DIGEST_SIZE 32
+
+// Incremental hashing context. Only the unprocessed tail of the
+// message (less than one block) is buffered, so any amount of input
+// can be hashed in constant memory.
+struct sha256_ctx {
+    uint state[8];
+    uint64 len;                    // total bytes passed to sha256_update
+    uchar buf[SHA256_BLOCK_SIZE];  // partial block, len % 64 bytes used
+};
+
+void sha256_init(struct sha256_ctx *ctx);
+void sha256_update(struct sha256_ctx *ctx, const uchar *data, uint len);
+void sha256_final(struct sha256_ctx *ctx, uchar *output);
+
+// Tree (Merkle) hashing, so that one digest of a large input can be
+// computed on many harts. The input is split into SHA256_TREE_LEAF
+// byte leaves; the last may be shorter, and an empty input is a
+// single empty leaf. The root is the RFC 6962 Merkle tree hash of
+// the leaves:
+//   leaf hash:  SHA-256(0x00 || leaf)
+//   node hash:  SHA-256(0x01 || left || right)
+// where n > 1 leaves split into the first k and the remaining n - k,
+// k being the largest power of two less than n. The shape depends
+// only on the input length, so the root is the same however many
+// workers hash the leaves.
+#define SHA256_TREE_LEAF  16384
+#define SHA256_TREE_DEPTH 24   // enough for 2^24 leaves
+
+// Builds the root from leaf hashes supplied in order, keeping only
+// the roots of the complete subtrees seen so far.
+struct sha256_tree {
+    uchar stack[SHA256_TREE_DEPTH][SHA256_DIGEST_SIZE];
+    int depth;                 // entries used in stack
+    uint64 nleaves;
+};
+
+void sha256_leaf_init(struct sha256_ctx *ctx);
+void sha256_tree_init(struct sha256_tree *tree);
+void sha256_tree_add(struct sha256_tree *tree, const uchar *leaf_hash);
+void sha256_tree_final(struct sha256_tree *tree, uchar *output);
+
+// One-shot tree hash of a buffer held entirely in memory.
+void sha256_tree(const uchar *input, uint len, uchar *output);
+
+// HMAC-SHA256 (RFC 2104). A key is prepared once: its inner and
+// outer midstates are the states after compressing the key XOR
+// ipad and the key XOR opad blocks. Each MAC then costs only the
+// message blocks and the two final blocks.
+struct sha256_hmac_key {
+    uint inner[8];
+    uint outer[8];
+};
+
+void sha256_hmac_setkey(struct sha256_hmac_key *key, const uchar *k, uint klen);
+void sha256_hmac_init(struct sha256_ctx *ctx, const struct sha256_hmac_key *key);
+void sha256_hmac_final(struct sha256_ctx *ctx, const struct sha256_hmac_key *key, uchar *mac);
+
+// One-shot MAC of a buffer held entirely in memory.
+void sha256_hmac(const struct sha256_hmac_key *key, const uchar *input, uint len, uchar *mac);
+
+// PBKDF2-HMAC-SHA256 (RFC 8018). Output block index (from 1) is
+// the XOR of iterations chained HMACs; blocks are independent of
+// each other, so they can be derived on different harts.
+void sha256_pbkdf2_block(const struct sha256_hmac_key *key, const uchar *salt, uint saltlen,
+                         uint iterations, uint index, uchar *output);
+void sha256_pbkdf2(const uchar *password, uint passlen, const uchar *salt, uint saltlen,
+                   uint iterations, uchar *output, uint outlen);
+
+// Arguments of the sha256pbkdf2() system call; addresses are user
+// virtual addresses.
+struct sha256_pbkdf2_args {
+    uint64 password;
+    uint64 salt;
+    uint64 output;
+    uint passlen;
+    uint saltlen;       // at most SHA256_PBKDF2_MAXSALT
+    uint iterations;    // at most SHA256_PBKDF2_MAXITER
+    uint outlen;        // at most SHA256_PBKDF2_MAXOUT
+};
+
+#define SHA256_PBKDF2_MAXSALT 512
+#define SHA256_PBKDF2_MAXOUT  (16 * SHA256_DIGEST_SIZE)
+
+// The blocks run on the shared hashing workers and cannot be killed,
+// so the kernel caps the iterations to keep one call to seconds.
+#define SHA256_PBKDF2_MAXITER 1000000
+
+// One message for the sha256batch() system call: hash len bytes at
+// input into the SHA256_DIGEST_SIZE bytes at output. Addresses are
+// user virtual addresses.
+struct sha256_desc {
+    uint64 input;
+    uint64 output;
+    uint len;
+    uint pad;
+};
+
+// Submission and completion queues shared between a process and the
+// kernel, in the page sha256ring() maps. The process fills sq[] and
+// advances sq_tail, then calls sha256ringenter(); the kernel posts a
+// completion per request to cq[] and advances cq_tail, and the
+// process reaps them and advances cq_head. Indices run freely and
+// are taken modulo the queue size. Each side writes entries before
+// the index that publishes them (__sync_synchronize()).
+#define SHA256_RING_SQ 32
+#define SHA256_RING_CQ 64
+
+struct sha256_sqe {
+    uint64 input;       // user address of the message
+    uint64 user_data;   // passed back in the completion
+    uint len;
+    uint pad;
+};
+
+struct sha256_cqe {
+    uint64 user_data;
+    int status;         // 0, or -1 if the message was not readable
+    uint pad;
+    uchar digest[SHA256_DIGEST_SIZE];
+};
+
+struct sha256_ring {
+    uint sq_head;       // written by the kernel
+    uint sq_tail;       // written by the process
+    uint cq_head;       // written by the process
+    uint cq_tail;       // written by the kernel
+    uint pad[12];
+    struct sha256_sqe sq[SHA256_RING_SQ];
+    struct sha256_cqe cq[SHA256_RING_CQ];
+};
+
+// sha256ctl() operations
+#define SHA256_CTL_WORKERS     1  // let arg kernel hashing workers run; returns how many
+#define SHA256_CTL_NWORKERS    2  // returns the number of kernel hashing workers
+#define SHA256_CTL_LANES       3  // if arg > 0, hash arg batch messages in lockstep; returns the lane count
+#define SHA256_CTL_HMACDEL     4  // remove HMAC key arg from the kernel key table
+#define SHA256_CTL_CACHEHITS   5  // returns whole-file digests served from the kernel cache
+#define SHA256_CTL_CACHEMISSES 6  // returns whole-file digests that had to be computed
+#define SHA256_CTL_CACHERESET  7  // zero both counters
+#define SHA256_CTL_SELFTEST    8  // returns 1 if the boot self-test passed, 0 if still running, -1 if it failed
+#define SHA256_CTL_SELFTESTCYCLES 9  // returns cycles the passing self-test took, 0 if unknown
+
+// Where sha256encrypt() spends its time, counted per hart by the
+// sha256stats() system call. The trap phase is usertrap() on the way
+// in and out; the trampoline itself is not counted. A phase that
+// moved to another hart part way is left out, since the harts' cycle
+// counters do not agree.
+#define SHA256_PH_TRAP      0
+#define SHA256_PH_COPYIN    1
+#define SHA256_PH_TRANSFORM 2
+#define SHA256_PH_COPYOUT   3
+#define SHA256_NPHASES      4
+
+struct sha256_phase {
+    uint64 calls;       // system calls that went through the phase
+    uint64 bytes;
+    uint64 cycles;
+};
+
+struct sha256_stats {
+    struct sha256_phase phase[SHA256_NPHASES];
+};
+
+// One-shot hash of a buffer held entirely in memory.
+void sha256(const uchar *input, uint len, uchar *output);
+
+// Compress one 64-byte block, or nblocks consecutive blocks, into state.
+void sha256_transform(uint *state, const uchar *block);
+void sha256_blocks(uint *state, const uchar *data, uint64 nblocks);
+
+// The original rolled-loop compression function, for comparison.
+void sha256_blocks_loop(uint *state, const uchar *data, uint64 nblocks);
+
+// Compression backends. sha256_blocks() uses the fastest one the
+// hart supports, found through sha256caps() on first use: in the
+// kernel from the device tree ISA string, in user programs through
+// the sha256caps system call. sha256_select() overrides the choice.
+#define SHA256_CAP_ZKNH  (1 << 0)   // RISC-V Zknh scalar SHA-256 instructions
+#define SHA256_CAP_V     (1 << 1)   // RISC-V vector extension (kernel only)
+
+int sha256caps(void);
+void sha256_select(int caps);
+void sha256_blocks_generic(uint *state, const uchar *data, uint64 nblocks);
+void sha256_blocks_zknh(uint *state, const uchar *data, uint64 nblocks);
+
+// Compress nblocks blocks of each of two independent messages with
+// their rounds interleaved, for harts without vectors. Faster than
+// two sha256_blocks calls on a hart that can issue more than one
+// instruction per cycle.
+void sha256_blocks_x2(uint *state0, uint *state1, const uchar *data0,
+                      const uchar *data1, uint64 nblocks);
+void sha256_blocks_x2_generic(uint *state0, uint *state1, const uchar *data0,
+                              const uchar *data1, uint64 nblocks);
+void sha256_blocks_x2_zknh(uint *state0, uint *state1, const uchar *data0,
+                           const uchar *data1, uint64 nblocks);
+
+// Multi-buffer hashing: n messages of the same length len, stride
+// bytes apart, hashed in groups of sha256_multi_lanes() messages
+// that go through the compression function in lockstep, one per
+// vector lane where the backend has them. Digests are written
+// SHA256_DIGEST_SIZE bytes apart at output.
+#define SHA256_MAXLANES 16
+
+void sha256_multi(const uchar *data, uint64 stride, uint len, int n, uchar *output);
+
+// Set the group size (clamped to 1..SHA256_MAXLANES) if lanes > 0;
+// returns the group size in use. The default is 8.
+int sha256_multi_lanes(int lanes);
+
+// Compress nblocks blocks of each of lanes messages, stride bytes
+// apart. state holds 8 words per lane, lane after lane.
+typedef void (*sha256_multi_fn)(uint *state, const uchar *data, uint64 stride,
+                                uint64 nblocks, int lanes);
+
+void sha256_multi_blocks(uint *state, const uchar *data, uint64 stride, uint64 nblocks, int lanes);
+void sha256_multi_blocks_generic(uint *state, const uchar *data, uint64 stride, uint64 nblocks, int lanes);
+void sha256_select_multi(sha256_multi_fn fn);
@@ -1,200 +1,328 @@
 #include "types.h"
-#include "spinlock.h"
-
-extern struct spinlock tickslock; // Synchronization for ticks
-void acquire(struct spinlock *lk);
-void release(struct spinlock *lk);
-
-int consolewrite(int user_src, uint64 src, int n);
-
-// Constants for SHA-256
-static const uint K[64] = {
-    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
-    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
-    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
-    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
-    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
-    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
-    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
-    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
-    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-};
+#include "riscv.h"
+#include "defs.h"
+#include "sha256.h"
+#include "hashstat.h"
 
-static uint H[8] = {
-    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
-    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
-};
+// Hash len bytes of user memory starting at va without copying it.
+// Each page is looked up in the process page table and read
+// through the kernel's direct mapping of physical memory.
+// Returns -1 if any page is not mapped for the user.
+int sha256_uvm(pagetable_t pagetable, struct sha256_ctx *ctx, uint64 va, uint64 len) {
+    uint64 n, va0, pa0;
 
-// Helper functions
-static uint right_rotate(uint value, unsigned int count) {
-    return (value >> count) | (value << (32 - count));
+    while (len > 0) {
+        va0 = PGROUNDDOWN(va);
+        pa0 = walkaddr(pagetable, va0);
+        if (pa0 == 0)
+            return -1;
+        n = PGSIZE - (va - va0);
+        if (n > len)
+            n = len;
+        sha256_update(ctx, (uchar *)(pa0 + (va - va0)), n);
+        len -= n;
+        va += n;
+    }
+    return 0;
 }
 
-static void sha256_transform(uint *state, const uchar *block) {
-    uint W[64];
-    uint a, b, c, d, e, f, g, h;
+// SHA256_CAP_* features of this machine, found by sha256_hwinit()
+static int hwcaps;
 
-    // Prepare message schedule
-    for (int i = 0; i < 16; ++i) {
-        W[i] = (block[i * 4] << 24) | (block[i * 4 + 1] << 16) |
-               (block[i * 4 + 2] << 8) | block[i * 4 + 3];
-    }
-    for (int i = 16; i < 64; ++i) {
-        uint s0 = right_rotate(W[i - 15], 7) ^ right_rotate(W[i - 15], 18) ^ (W[i - 15] >> 3);
-        uint s1 = right_rotate(W[i - 2], 17) ^ right_rotate(W[i - 2], 19) ^ (W[i - 2] >> 10);
-        W[i] = W[i - 16] + s0 + W[i - 7] + s1;
-    }
+int sha256caps(void) {
+    return hwcaps;
+}
 
-    // Initialize working variables
-    a = state[0];
-    b = state[1];
-    c = state[2];
-    d = state[3];
-    e = state[4];
-    f = state[5];
-    g = state[6];
-    h = state[7];
-
-    // Main computation
-    for (int i = 0; i < 64; ++i) {
-        uint S1 = right_rotate(e, 6) ^ right_rotate(e, 11) ^ right_rotate(e, 25);
-        uint ch = (e & f) ^ (~e & g);
-        uint temp1 = h + S1 + ch + K[i] + W[i];
-        uint S0 = right_rotate(a, 2) ^ right_rotate(a, 13) ^ right_rotate(a, 22);
-        uint maj = (a & b) ^ (a & c) ^ (b & c);
-        uint temp2 = S0 + maj;
-
-        h = g;
-        g = f;
-        f = e;
-        e = d + temp1;
-        d = c;
-        c = b;
-        b = a;
-        a = temp1 + temp2;
-    }
+// Flattened device tree tokens
+#define FDT_MAGIC      0xd00dfeed
+#define FDT_BEGIN_NODE 1
+#define FDT_END_NODE   2
+#define FDT_PROP       3
+#define FDT_NOP        4
 
-    // Add the compressed chunk to the current state
-    state[0] += a;
-    state[1] += b;
-    state[2] += c;
-    state[3] += d;
-    state[4] += e;
-    state[5] += f;
-    state[6] += g;
-    state[7] += h;
+static uint fdt32(const uchar *p) {
+    return ((uint)p[0] << 24) | ((uint)p[1] << 16) | ((uint)p[2] << 8) | p[3];
 }
 
-void sha256(const uchar *input, uint len, uchar *output) {
-    uint state[8];
-    uchar block[64];
-    uint i, j;
+// Return the riscv,isa property of the first cpu node in the
+// device tree at fdt, or 0 if there is none.
+static const char *fdt_isa(const uchar *fdt) {
+    const uchar *p;
+    const char *strings, *name;
+    int depth = 0, cpu_depth = 0;
+    uint len;
 
-    for (i = 0; i < 8; ++i) state[i] = H[i];
+    if (fdt == 0 || fdt32(fdt) != FDT_MAGIC)
+        return 0;
+    p = fdt + fdt32(fdt + 8);                     // off_dt_struct
+    strings = (const char *)fdt + fdt32(fdt + 12); // off_dt_strings
 
-    // Process complete 64-byte blocks
-    for (i = 0; i + 64 <= len; i += 64) {
-        sha256_transform(state, input + i);
+    for (;;) {
+        switch (fdt32(p)) {
+        case FDT_BEGIN_NODE:
+            name = (const char *)p + 4;
+            depth++;
+            if (cpu_depth == 0 && strncmp(name, "cpu@", 4) == 0)
+                cpu_depth = depth;
+            p += 4 + ((strlen(name) + 1 + 3) & ~3);
+            break;
+        case FDT_END_NODE:
+            if (depth == cpu_depth)
+                return 0; // first cpu node has no riscv,isa
+            depth--;
+            p += 4;
+            break;
+        case FDT_PROP:
+            len = fdt32(p + 4);
+            name = strings + fdt32(p + 8);
+            if (depth == cpu_depth && strncmp(name, "riscv,isa", 10) == 0)
+                return (const char *)p + 12;
+            p += 12 + ((len + 3) & ~3);
+            break;
+        case FDT_NOP:
+            p += 4;
+            break;
+        default:
+            return 0; // FDT_END or garbage
+        }
     }
+}
 
-    // Handle padding for the last block
-    j = len % 64;
-    for (int k = 0; k < j; ++k) block[k] = input[i + k];
-    block[j++] = 0x80;
-    if (j > 56) {
-        while (j < 64) block[j++] = 0;
-        sha256_transform(state, block);
-        j = 0;
-    }
-    while (j < 56) block[j++] = 0;
-    unsigned long bit_len = len * 8;
-    for (int k = 0; k < 8; ++k) block[63 - k] = (bit_len >> (k * 8)) & 0xff;
-    sha256_transform(state, block);
-
-    // Output the final hash
-    for (i = 0; i < 8; ++i) {
-        output[i * 4] = (state[i] >> 24) & 0xff;
-        output[i * 4 + 1] = (state[i] >> 16) & 0xff;
-        output[i * 4 + 2] = (state[i] >> 8) & 0xff;
-        output[i * 4 + 3] = state[i] & 0xff;
+// Does the ISA string, e.g. "rv64imafdc_zicsr_zknh", name extension
+// ext? Multi-letter extensions follow underscores.
+static int isa_has(const char *isa, const char *ext) {
+    const char *p = isa;
+    int n;
+
+    while (*p) {
+        while (*p == '_')
+            p++;
+        for (n = 0; p[n] && p[n] != '_'; n++)
+            ;
+        if (n == strlen(ext) && strncmp(p, ext, n) == 0)
+            return 1;
+        p += n;
     }
+    return 0;
 }
 
-// Kernel-compatible string length function
-int kernel_strlen(const char *str) {
-    int len = 0;
-    while (str[len] != '\0') len++;
-    return len;
+// Does the ISA string list single-letter extension c? Those come
+// right after "rv64" in the first token.
+static int isa_has_letter(const char *isa, char c) {
+    const char *p = isa;
+
+    if (p[0] != 'r' || p[1] != 'v')
+        return 0;
+    for (p += 2; *p >= '0' && *p <= '9'; p++)
+        ;
+    for (; *p && *p != '_'; p++)
+        if (*p == c)
+            return 1;
+    return 0;
 }
 
-void sha256_test(void) {
-    char *message = "a quick brown fox jumps over the lazy dog";
-    uchar hash[32];
+// sstatus.VS, the vector unit state; 0 means vector instructions trap
+#define SSTATUS_VS (3L << 9)
 
-    sha256((uchar *)message, kernel_strlen(message), hash);
+// Blocks per lane compressed with interrupts off. xv6 does not save
+// vector registers across traps or context switches, so the vector
+// unit is only switched on with interrupts off, and only for a
+// bounded stretch.
+#define RVV_BLOCKS 8
 
-    // Output buffer to store the formatted hash and ticks
-    char output[256]; // Increased size to accommodate ticks
-    int offset = 0;
+// Multi-buffer backend on RVV, one message per 32-bit vector lane.
+// The vector loads take whole words, so messages that are not
+// 4-byte aligned, or a stride that is not, go to the portable code.
+static void sha256_multi_blocks_rvv(uint *state, const uchar *data, uint64 stride,
+                                    uint64 nblocks, int lanes) {
+    uint64 n;
 
-    // Write the prefix
-    const char *prefix = "SHA-256 hash: ";
-    for (int i = 0; prefix[i] != '\0'; i++) {
-        output[offset++] = prefix[i];
+    if (((uint64)data | stride) & 3) {
+        sha256_multi_blocks_generic(state, data, stride, nblocks, lanes);
+        return;
     }
-
-    // Write the hash in hexadecimal
-    for (int i = 0; i < 32; ++i) {
-        uchar byte = hash[i];
-        const char *hex = "0123456789abcdef";
-        output[offset++] = hex[byte >> 4];       // High nibble
-        output[offset++] = hex[byte & 0x0F];    // Low nibble
+    while (nblocks > 0) {
+        n = nblocks < RVV_BLOCKS ? nblocks : RVV_BLOCKS;
+        push_off();
+        w_sstatus(r_sstatus() | SSTATUS_VS);
+        sha256_rvv_blocks(state, data, stride, n, lanes);
+        w_sstatus(r_sstatus() & ~SSTATUS_VS);
+        pop_off();
+        data += n * SHA256_BLOCK_SIZE;
+        nblocks -= n;
     }
+}
+
+// Pick the SHA-256 backend from the boot hart's ISA string.
+// Called on hart 0 before kinit(), which would overwrite the
+// device tree at the top of RAM. A backend is only used after it
+// matches the portable code on a test input.
+void sha256_hwinit(uint64 dtb) {
+    const char *isa = fdt_isa((const uchar *)dtb);
+    uint generic[8] = { 0 }, fast[8] = { 0 };
+    uint lanes[4][8] = { 0 };
+    uchar block[64 * 4] __attribute__((aligned(8)));
 
-    // Add a newline after the hash
-    output[offset++] = '\n';
+    hwcaps = 0;
+    if (isa && (isa_has(isa, "zknh") || isa_has(isa, "zkn") || isa_has(isa, "zk")))
+        hwcaps |= SHA256_CAP_ZKNH;
+    if (isa && isa_has_letter(isa, 'v'))
+        hwcaps |= SHA256_CAP_V;
 
-    // Retrieve the tick count
-    extern uint64 ticks; // Use xv6's global ticks variable
-    acquire(&tickslock); // Locking for thread safety
-    uint64 current_ticks = ticks;
-    release(&tickslock);
+    for (int i = 0; i < sizeof(block); i++)
+        block[i] = i * 7;
 
-    // Write the ticks
-    const char *tick_prefix = "Number of ticks: ";
-    for (int i = 0; tick_prefix[i] != '\0'; i++) {
-        output[offset++] = tick_prefix[i];
+    if (hwcaps & SHA256_CAP_ZKNH) {
+        sha256_blocks_generic(generic, block, 4);
+        sha256_blocks_zknh(fast, block, 4);
+        for (int i = 0; i < 8; i++) {
+            if (generic[i] != fast[i]) {
+                hwcaps &= ~SHA256_CAP_ZKNH;
+                break;
+            }
+        }
     }
 
-    // Convert ticks to string
-    char tick_buffer[32];
-    int tick_offset = 0;
-    if (current_ticks == 0) {
-        tick_buffer[tick_offset++] = '0';
-    } else {
-        while (current_ticks > 0) {
-            tick_buffer[tick_offset++] = '0' + (current_ticks % 10);
-            current_ticks /= 10;
+    // Four one-block messages, one per vector lane
+    if (hwcaps & SHA256_CAP_V) {
+        sha256_multi_blocks_rvv(lanes[0], block, 64, 1, 4);
+        for (int l = 0; l < 4; l++) {
+            for (int i = 0; i < 8; i++)
+                generic[i] = 0;
+            sha256_blocks_generic(generic, block + 64 * l, 1);
+            for (int i = 0; i < 8; i++)
+                if (generic[i] != lanes[l][i])
+                    hwcaps &= ~SHA256_CAP_V;
+        }
+    }
+
+    sha256_select(hwcaps);
+    if (hwcaps & SHA256_CAP_V)
+        sha256_select_multi(sha256_multi_blocks_rvv);
+}
+
+// Known-answer self-test. Each vector is the SHA-256 of len bytes
+// of 'a', or of msg if it is set, chosen to put the padding at
+// every block boundary: 55 bytes still fit the length in one block,
+// 56 to 64 spill it into a second.
+static const struct {
+    const char *msg;
+    uint len;
+    const char *digest;
+} selftest_vectors[] = {
+    { 0, 0,    "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+    { "abc", 3, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+    { 0, 55,   "9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318" },
+    { 0, 56,   "b35439a4ac6f0948b6d6f9e3c6af0f5f590ce20f1bde7090ef7970686ec6738a" },
+    { 0, 63,   "7d3e74a05d7db15bce4ad9ec0658ea98e3f06eeecf16b4c6fff2da457ddc2f34" },
+    { 0, 64,   "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb" },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56,
+               "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+    { 0, 119,  "31eba51c313a5c08226adf18d4a359cfdfd8d2e816b13f4af952f7ea6584dcfb" },
+    { 0, 120,  "2f3d335432c70b580af0e8e1b3674a7c020d683aa5f73aaaedfdc55af904c21c" },
+    { 0, 1000, "41edece42d63e8d9bf515a9ba6932e1c20cbc9f5a5d134645adb5db1b9737ea3" },
+};
+
+#define SELFTEST_NVECTORS (sizeof(selftest_vectors) / sizeof(selftest_vectors[0]))
+#define SELFTEST_MULTI    4    // messages hashed together by sha256_multi
+#define SELFTEST_STRIDE   128  // bytes between them
+
+static uchar selftest_buf[1000] __attribute__((aligned(8))); // so sha256_multi() can use vectors
+static int selftest_claimed;
+static int selftest_status;     // 0 until done, then 1 if passed or -1
+static uint64 selftest_cycles;  // taken by a passing run; 0 if it changed harts
+
+static int hexval(char c) {
+    return c <= '9' ? c - '0' : c - 'a' + 10;
+}
+
+static int digest_eq(const uchar *digest, const char *hex) {
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++)
+        if (digest[i] != (hexval(hex[2 * i]) << 4 | hexval(hex[2 * i + 1])))
+            return 0;
+    return 1;
+}
+
+// Check every vector one-shot, through sha256_update() in pieces
+// that straddle the block buffer, and the 120-byte one through the
+// multi-buffer backend. Returns the index of the first vector that
+// fails, or -1.
+static int selftest_run(void) {
+    struct sha256_ctx ctx;
+    uchar digest[SHA256_DIGEST_SIZE];
+    uchar multi[SELFTEST_MULTI][SHA256_DIGEST_SIZE];
+    const uchar *msg;
+    uint len, n;
+
+    for (int v = 0; v < SELFTEST_NVECTORS; v++) {
+        msg = selftest_vectors[v].msg ? (const uchar *)selftest_vectors[v].msg : selftest_buf;
+        len = selftest_vectors[v].len;
+
+        sha256(msg, len, digest);
+        if (!digest_eq(digest, selftest_vectors[v].digest))
+            return v;
+
+        sha256_init(&ctx);
+        for (uint off = 0, step = 1; off < len; off += n, step += 62) {
+            n = len - off < step ? len - off : step;
+            sha256_update(&ctx, msg + off, n);
         }
-        // Reverse the tick_buffer as we constructed it backward
-        for (int i = tick_offset - 1; i >= 0; i--) {
-            output[offset++] = tick_buffer[i];
+        sha256_final(&ctx, digest);
+        if (!digest_eq(digest, selftest_vectors[v].digest))
+            return v;
+
+        if (!selftest_vectors[v].msg && len == 120) {
+            sha256_multi(selftest_buf, SELFTEST_STRIDE, len, SELFTEST_MULTI, multi[0]);
+            for (int i = 0; i < SELFTEST_MULTI; i++)
+                if (!digest_eq(multi[i], selftest_vectors[v].digest))
+                    return v;
         }
     }
+    return -1;
+}
+
+// Run the known-answer tests once; later calls return at once.
+// Called by every hashing worker as it starts, so the tests run in
+// the background on whichever hart takes the first worker, instead
+// of holding up boot. If the selected backends fail, the portable
+// code takes over and is tested in turn.
+void sha256_selftest(void) {
+    uint64 start, cycles;
+    int hart, v;
 
-    // Add a newline
-    output[offset++] = '\n';
+    if (__sync_lock_test_and_set(&selftest_claimed, 1))
+        return;
 
-    // Null-terminate the string for safety (not required by consolewrite)
-    output[offset] = '\0';
+    for (int i = 0; i < sizeof(selftest_buf); i++)
+        selftest_buf[i] = 'a';
+
+    hashstat_mark(&start, &hart);
+    if ((v = selftest_run()) >= 0) {
+        printf("sha256: self-test failed on %d bytes, using portable code\n",
+               selftest_vectors[v].len);
+        sha256_select(0);
+        sha256_select_multi(sha256_multi_blocks_generic);
+        if ((v = selftest_run()) >= 0)
+            printf("sha256: self-test of portable code failed on %d bytes\n",
+                   selftest_vectors[v].len);
+        __sync_synchronize();
+        selftest_status = -1;
+        return;
+    }
+    cycles = hashstat_since(start, hart);
+    selftest_cycles = cycles == HASHSTAT_LOST ? 0 : cycles;
+    __sync_synchronize();
+    selftest_status = 1;
+}
+
+// 1 if the self-test passed, 0 if it hasn't finished, or -1 if it
+// failed.
+int sha256_selftest_result(void) {
+    return selftest_status;
+}
 
-    // Write to the console
-    consolewrite(0, (uint64)output, offset);
+// Cycles the passing self-test took, or 0 if it hasn't passed or
+// moved between harts, whose cycle counters do not agree.
+uint64 sha256_selftest_cycles(void) {
+    return selftest_cycles;
 }
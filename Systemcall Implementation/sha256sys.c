@@ -1,18 +1,28 @@
 #include <stddef.h>
 #include "user.h"
+#include "kernel/param.h"
+#include "kernel/sha256.h"
+#include "kernel/fcntl.h"
 
-// Implement getchar for xv6
+// Implement getchar for xv6, reading stdin a block at a time rather
+// than making one system call per byte
 int getchar(void) {
-    char c;
-    if (read(0, &c, 1) == 1) { // Read from stdin (fd = 0)
-        return c;
-    } else {
-        return -1; // EOF
+    static char buf[512];
+    static int pos, len;
+
+    if (pos == len) {
+        pos = 0;
+        if ((len = read(0, buf, sizeof(buf))) <= 0) { // Read from stdin (fd = 0)
+            len = 0;
+            return -1; // EOF
+        }
     }
+    return (uchar)buf[pos++];
 }
 
-// Custom realloc implementation for xv6
-void* realloc(void *ptr, size_t new_size) {
+// Custom realloc implementation for xv6. umalloc keeps no block
+// sizes a caller can query, so the caller passes the old size.
+void* realloc(void *ptr, size_t old_size, size_t new_size) {
     if (ptr == NULL) {
         return malloc(new_size); // Behave like malloc if ptr is NULL
     }
@@ -28,12 +38,707 @@ void* realloc(void *ptr, size_t new_size) {
     }
 
     // Copy old data to new memory
-    memcpy(new_ptr, ptr, new_size); // Note: assumes new_size is not less than old size
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
     free(ptr); // Free old memory
     return new_ptr;
 }
 
-int main() {
+// Shortest time each benchmark loop runs for, in rdtime units
+// (0.1 s), so that inputs hashing in well under that still produce
+// a usable rate.
+#define BENCH_TIME (TIMER_HZ / 10)
+
+// Allocate size bytes for a benchmark, or exit.
+void *bench_alloc(int size) {
+    void *p = malloc(size > 0 ? size : 1);
+
+    if (p == NULL) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    return p;
+}
+
+// Allocate count records of size bytes, back to back, filled with
+// the pattern every benchmark hashes.
+char *bench_records(int count, int size) {
+    char *buf = bench_alloc(count * size);
+
+    for (int i = 0; i < count * size; i++)
+        buf[i] = i * 7;
+    return buf;
+}
+
+// Times one benchmark loop: bench_start(), then passes of work, each
+// followed by bench_next() with the units (records or bytes) it did,
+// until bench_next() returns 0.
+struct bench_timer {
+    uint64 start;
+    uint64 elapsed;     // rdtime units
+    uint64 units;
+};
+
+void bench_start(struct bench_timer *t) {
+    t->elapsed = 0;
+    t->units = 0;
+    t->start = rdtime();
+}
+
+int bench_next(struct bench_timer *t, uint64 units) {
+    t->units += units;
+    t->elapsed = rdtime() - t->start;
+    return t->elapsed < BENCH_TIME;
+}
+
+// Units per second over the loop.
+uint64 bench_rate(struct bench_timer *t) {
+    return t->elapsed ? t->units * TIMER_HZ / t->elapsed : 0;
+}
+
+// The hashing paths compared by bench()
+#define PATH_USER    0  // user-space library
+#define PATH_SYSCALL 1  // sha256encrypt: copyin through a bounce page
+#define PATH_DIRECT  2  // sha256direct: kernel reads the user pages in place
+
+const char *path_names[] = { "user", "syscall", "direct" };
+
+int hash_path(int path, char *buf, int size, uchar *hash) {
+    switch (path) {
+    case PATH_USER:
+        sha256((uchar *)buf, size, hash);
+        return 0;
+    case PATH_SYSCALL:
+        return sha256encrypt(buf, size, hash);
+    case PATH_DIRECT:
+        return sha256direct(buf, size, hash);
+    }
+    return -1;
+}
+
+// Hash a size-byte buffer repeatedly along each path and print the
+// throughput in MB/s and the bytes hashed per thousand cycles.
+void bench(int size) {
+    char *buf = bench_records(1, size);
+    uchar hash[3][32];
+    struct bench_timer t;
+    int iters;
+    uint64 start_cycles, cycles;
+
+    for (int path = PATH_USER; path <= PATH_DIRECT; path++) {
+        iters = 0;
+        start_cycles = rdcycle();
+        bench_start(&t);
+        do {
+            if (hash_path(path, buf, size, hash[path]) < 0) {
+                printf("SHA-256 %s hash failed\n", path_names[path]);
+                exit(1);
+            }
+            iters++;
+        } while (bench_next(&t, size));
+        cycles = rdcycle() - start_cycles;
+
+        printf("%s %d bytes: ", path_names[path], size);
+        print_fixed(1, bench_rate(&t) / 10000);
+        printf(" MB/s, %d B/kcycle (%d runs)\n",
+               cycles ? (int)(t.units * 1000 / cycles) : 0, iters);
+    }
+
+    if (memcmp(hash[PATH_USER], hash[PATH_SYSCALL], 32) != 0 ||
+        memcmp(hash[PATH_USER], hash[PATH_DIRECT], 32) != 0)
+        printf("digest mismatch at %d bytes\n", size);
+
+    free(buf);
+}
+
+// Describe count records of size bytes at buf for sha256batch, with
+// their digests going to hashes.
+struct sha256_desc *bench_descs(char *buf, int count, int size, uchar *hashes) {
+    struct sha256_desc *descs = bench_alloc(count * sizeof(struct sha256_desc));
+
+    for (int i = 0; i < count; i++) {
+        descs[i].input = (uint64)(buf + i * size);
+        descs[i].output = (uint64)(hashes + i * 32);
+        descs[i].len = size;
+    }
+    return descs;
+}
+
+// Time one sha256encrypt call per record for count records of size
+// bytes, print records/sec, and leave the digests in hashes.
+void bench_percall(char *buf, int count, int size, uchar *hashes) {
+    struct bench_timer t;
+
+    bench_start(&t);
+    do {
+        for (int i = 0; i < count; i++) {
+            if (sha256encrypt(buf + i * size, size, hashes + i * 32) < 0) {
+                printf("SHA-256 system call failed\n");
+                exit(1);
+            }
+        }
+    } while (bench_next(&t, count));
+    printf("per-call %d x %d bytes: %d records/sec\n", count, size, (int)bench_rate(&t));
+}
+
+// Time sha256batch on descs, count records at a time, and return
+// records per second.
+uint64 bench_sha256batch(struct sha256_desc *descs, int count) {
+    struct bench_timer t;
+
+    bench_start(&t);
+    do {
+        if (sha256batch(descs, count) != count) {
+            printf("SHA-256 batch system call failed\n");
+            exit(1);
+        }
+    } while (bench_next(&t, count));
+    return bench_rate(&t);
+}
+
+// Hash count records of size bytes, first with one sha256encrypt
+// call per record and then with sha256batch calls of count records,
+// and print the records hashed per second by each.
+void bench_batch(int count, int size) {
+    char *buf = bench_records(count, size);
+    uchar *hashes = bench_alloc(count * 32);
+    uchar *batch_hashes = bench_alloc(count * 32);
+    struct sha256_desc *descs = bench_descs(buf, count, size, batch_hashes);
+
+    bench_percall(buf, count, size, hashes);
+    printf("batch    %d x %d bytes: %d records/sec\n", count, size,
+           (int)bench_sha256batch(descs, count));
+
+    if (memcmp(hashes, batch_hashes, count * 32) != 0)
+        printf("digest mismatch in batch of %d x %d bytes\n", count, size);
+
+    free(buf);
+    free(hashes);
+    free(batch_hashes);
+    free(descs);
+}
+
+// Hash batches of count records of size bytes with 1..N kernel
+// hashing workers active and print records per second and the
+// speedup over a single worker.
+void bench_scaling(int count, int size) {
+    char *buf = bench_records(count, size);
+    uchar *hashes = bench_alloc(count * 32);
+    struct sha256_desc *descs = bench_descs(buf, count, size, hashes);
+    int nworkers = sha256ctl(SHA256_CTL_NWORKERS, 0);
+    uint64 rate, base = 0;
+
+    for (int w = 1; w <= nworkers; w++) {
+        sha256ctl(SHA256_CTL_WORKERS, w);
+        rate = bench_sha256batch(descs, count);
+        if (w == 1)
+            base = rate;
+        printf("%d harts %d x %d bytes: %d records/sec, speedup ", w, count, size, (int)rate);
+        if (base)
+            print_fixed(1, rate * 100 / base);
+        else
+            printf("-");
+        printf("\n");
+    }
+    sha256ctl(SHA256_CTL_WORKERS, nworkers);
+
+    free(buf);
+    free(hashes);
+    free(descs);
+}
+
+// Tree-hash a size-byte buffer with the user library and with the
+// sha256tree system call on 1..N kernel workers. Every root must
+// match, whatever the number of workers.
+void bench_tree(int size) {
+    char *buf = bench_records(1, size);
+    uchar user_root[32], sys_root[32];
+    int nworkers = sha256ctl(SHA256_CTL_NWORKERS, 0);
+    struct bench_timer t;
+
+    bench_start(&t);
+    do {
+        sha256_tree((uchar *)buf, size, user_root);
+    } while (bench_next(&t, size));
+    printf("user tree       %d bytes: ", size);
+    print_fixed(1, bench_rate(&t) / 10000);
+    printf(" MB/s\n");
+
+    for (int w = 1; w <= nworkers; w++) {
+        sha256ctl(SHA256_CTL_WORKERS, w);
+        bench_start(&t);
+        do {
+            if (sha256tree(buf, size, sys_root) < 0) {
+                printf("SHA-256 tree system call failed\n");
+                exit(1);
+            }
+        } while (bench_next(&t, size));
+        printf("syscall tree %d harts %d bytes: ", w, size);
+        print_fixed(1, bench_rate(&t) / 10000);
+        printf(" MB/s\n");
+        if (memcmp(user_root, sys_root, 32) != 0)
+            printf("tree root mismatch with %d harts\n", w);
+    }
+    sha256ctl(SHA256_CTL_WORKERS, nworkers);
+
+    free(buf);
+}
+
+// Hash batches of same-length records in lockstep groups of 1, 4, 8
+// and 16 lanes, in user space with sha256_multi and in the kernel
+// through sha256batch (on vector lanes if the hart has RVV), and
+// print records per second for each message size.
+void bench_lanes(void) {
+    static const int lane_counts[] = { 1, 4, 8, 16 };
+    static const int sizes[] = { 32, 64, 128, 256, 512 };
+    int kernel_lanes = sha256ctl(SHA256_CTL_LANES, 0);
+    int user_lanes = sha256_multi_lanes(0);
+    char *buf = bench_records(1, 4096);
+    uchar *hashes = bench_alloc(32 * 32);
+    uchar *batch_hashes = bench_alloc(32 * 32);
+    struct sha256_desc *descs;
+    struct bench_timer t;
+    int count, size, lanes;
+
+    printf("vector unit: %s\n", (sha256caps() & SHA256_CAP_V) ? "yes" : "no");
+
+    for (int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size = sizes[s];
+        // One page of records, so the kernel can stage them in one copy
+        count = 4096 / size < 32 ? 4096 / size : 32;
+        descs = bench_descs(buf, count, size, batch_hashes);
+
+        for (int l = 0; l < sizeof(lane_counts) / sizeof(lane_counts[0]); l++) {
+            lanes = lane_counts[l];
+            sha256_multi_lanes(lanes);
+            sha256ctl(SHA256_CTL_LANES, lanes);
+
+            bench_start(&t);
+            do {
+                sha256_multi((uchar *)buf, size, size, count, hashes);
+            } while (bench_next(&t, count));
+            printf("user   %d lanes %d x %d bytes: %d records/sec\n", lanes, count, size,
+                   (int)bench_rate(&t));
+
+            printf("kernel %d lanes %d x %d bytes: %d records/sec\n", lanes, count, size,
+                   (int)bench_sha256batch(descs, count));
+
+            if (memcmp(hashes, batch_hashes, count * 32) != 0)
+                printf("digest mismatch with %d lanes at %d bytes\n", lanes, size);
+        }
+        free(descs);
+    }
+    sha256_multi_lanes(user_lanes);
+    sha256ctl(SHA256_CTL_LANES, kernel_lanes);
+
+    free(buf);
+    free(hashes);
+    free(batch_hashes);
+}
+
+// Check HMAC-SHA256 against RFC 4231 test case 2, then MAC count
+// messages of size bytes: rekeying the library for each message,
+// with the library's cached midstates, and with sha256hmac under a
+// key registered in the kernel. Prints messages per second for each.
+void bench_hmac(int count, int size) {
+    static const uchar expect[32] = {
+        0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24, 0x26,
+        0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83,
+        0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43
+    };
+    char *key = "Jefe";
+    char *msg = "what do ya want for nothing?";
+    char *buf = bench_records(count, size);
+    uchar mac[32], sys_mac[32];
+    struct sha256_hmac_key hk;
+    struct bench_timer t;
+    int id;
+
+    if ((id = sha256hmackey(key, strlen(key))) < 0) {
+        printf("SHA-256 HMAC key registration failed\n");
+        exit(1);
+    }
+    sha256_hmac_setkey(&hk, (uchar *)key, strlen(key));
+    sha256_hmac(&hk, (uchar *)msg, strlen(msg), mac);
+    if (sha256hmac(id, msg, strlen(msg), sys_mac) < 0) {
+        printf("SHA-256 HMAC system call failed\n");
+        exit(1);
+    }
+    if (memcmp(mac, expect, 32) != 0 || memcmp(sys_mac, expect, 32) != 0)
+        printf("HMAC mismatch with RFC 4231 test case 2\n");
+
+    bench_start(&t);
+    do {
+        for (int i = 0; i < count; i++) {
+            sha256_hmac_setkey(&hk, (uchar *)key, strlen(key));
+            sha256_hmac(&hk, (uchar *)buf + i * size, size, mac);
+        }
+    } while (bench_next(&t, count));
+    printf("rekeyed %d x %d bytes: %d messages/sec\n", count, size, (int)bench_rate(&t));
+
+    sha256_hmac_setkey(&hk, (uchar *)key, strlen(key));
+    bench_start(&t);
+    do {
+        for (int i = 0; i < count; i++)
+            sha256_hmac(&hk, (uchar *)buf + i * size, size, mac);
+    } while (bench_next(&t, count));
+    printf("cached  %d x %d bytes: %d messages/sec\n", count, size, (int)bench_rate(&t));
+
+    bench_start(&t);
+    do {
+        for (int i = 0; i < count; i++) {
+            if (sha256hmac(id, buf + i * size, size, sys_mac) < 0) {
+                printf("SHA-256 HMAC system call failed\n");
+                exit(1);
+            }
+        }
+    } while (bench_next(&t, count));
+    printf("syscall %d x %d bytes: %d messages/sec\n", count, size, (int)bench_rate(&t));
+
+    if (memcmp(mac, sys_mac, 32) != 0)
+        printf("HMAC mismatch between library and system call\n");
+
+    sha256ctl(SHA256_CTL_HMACDEL, id);
+    free(buf);
+}
+
+// Check PBKDF2-HMAC-SHA256 against a published test vector, then
+// derive keys of one output block per kernel hashing worker with
+// the library and with sha256pbkdf2 on 1..N harts, and print the
+// HMAC iterations per second.
+void bench_pbkdf2(int iterations) {
+    static const uchar expect[32] = {
+        0xc5, 0xe4, 0x78, 0xd5, 0x92, 0x88, 0xc8, 0x41, 0xaa, 0x53, 0x0d, 0xb6,
+        0x84, 0x5c, 0x4c, 0x8d, 0x96, 0x28, 0x93, 0xa0, 0x01, 0xce, 0x4e, 0x11,
+        0xa4, 0x96, 0x38, 0x73, 0xaa, 0x98, 0x13, 0x4a
+    };
+    char *password = "password";
+    char *salt = "salt";
+    int nworkers = sha256ctl(SHA256_CTL_NWORKERS, 0);
+    int outlen = nworkers * 32 < SHA256_PBKDF2_MAXOUT ? nworkers * 32 : SHA256_PBKDF2_MAXOUT;
+    uchar *key = malloc(outlen), *sys_key = malloc(outlen);
+    struct sha256_pbkdf2_args args;
+    uint64 start, elapsed;
+
+    if (key == NULL || sys_key == NULL) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+
+    args.password = (uint64)password;
+    args.passlen = strlen(password);
+    args.salt = (uint64)salt;
+    args.saltlen = strlen(salt);
+    args.output = (uint64)sys_key;
+
+    // password, salt, 4096 iterations, 32 bytes
+    sha256_pbkdf2((uchar *)password, strlen(password), (uchar *)salt, strlen(salt), 4096, key, 32);
+    args.iterations = 4096;
+    args.outlen = 32;
+    if (sha256pbkdf2(&args) < 0) {
+        printf("SHA-256 PBKDF2 system call failed\n");
+        exit(1);
+    }
+    if (memcmp(key, expect, 32) != 0 || memcmp(sys_key, expect, 32) != 0)
+        printf("PBKDF2 mismatch with test vector\n");
+
+    start = rdtime();
+    sha256_pbkdf2((uchar *)password, strlen(password), (uchar *)salt, strlen(salt),
+                  iterations, key, outlen);
+    elapsed = rdtime() - start;
+    printf("user       %d x %d iterations: %d iterations/s\n", outlen / 32, iterations,
+           (int)((uint64)iterations * (outlen / 32) * TIMER_HZ / (elapsed ? elapsed : 1)));
+
+    args.iterations = iterations;
+    args.outlen = outlen;
+    for (int w = 1; w <= nworkers; w++) {
+        sha256ctl(SHA256_CTL_WORKERS, w);
+        start = rdtime();
+        if (sha256pbkdf2(&args) < 0) {
+            printf("SHA-256 PBKDF2 system call failed\n");
+            exit(1);
+        }
+        elapsed = rdtime() - start;
+        printf("syscall %d harts %d x %d iterations: %d iterations/s\n", w, outlen / 32,
+               iterations,
+               (int)((uint64)iterations * (outlen / 32) * TIMER_HZ / (elapsed ? elapsed : 1)));
+        if (memcmp(key, sys_key, outlen) != 0)
+            printf("PBKDF2 mismatch with %d harts\n", w);
+    }
+    sha256ctl(SHA256_CTL_WORKERS, nworkers);
+
+    free(key);
+    free(sys_key);
+}
+
+// Hash a file with sha256fd once cold and then repeatedly, and show
+// the time per digest and the kernel digest cache's hit and miss
+// counts. Repeats of an unchanged file should all be hits.
+void bench_file(char *path) {
+    uchar first[32], hash[32];
+    uint64 start, cold, warm;
+    int fd, n, repeats = 100;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        printf("cannot open %s\n", path);
+        exit(1);
+    }
+    sha256ctl(SHA256_CTL_CACHERESET, 0);
+
+    start = rdtime();
+    if ((n = sha256fd(fd, 0, -1, first)) < 0) {
+        printf("SHA-256 fd system call failed\n");
+        exit(1);
+    }
+    cold = rdtime() - start;
+
+    start = rdtime();
+    for (int i = 0; i < repeats; i++) {
+        if (sha256fd(fd, 0, -1, hash) < 0 || memcmp(first, hash, 32) != 0) {
+            printf("SHA-256 fd digest changed\n");
+            exit(1);
+        }
+    }
+    warm = (rdtime() - start) / repeats;
+    close(fd);
+
+    printf("%s %d bytes: first %d us, repeat %d us, %d hits, %d misses\n", path, n,
+           (int)(cold * 1000000 / TIMER_HZ), (int)(warm * 1000000 / TIMER_HZ),
+           sha256ctl(SHA256_CTL_CACHEHITS, 0), sha256ctl(SHA256_CTL_CACHEMISSES, 0));
+}
+
+// Create file and append count chunks of size bytes to it, taking
+// the whole-file digest with sha256fd after each append. Each digest
+// should only hash the new bytes, so its time stays flat as the file
+// grows. Every digest is checked against the user library.
+void bench_append(char *path, int count, int size) {
+    char *buf = malloc(size > 0 ? size : 1);
+    uchar expect[32], hash[32];
+    struct sha256_ctx ctx, tmp;
+    uint64 start, elapsed;
+    int fd;
+
+    if (buf == NULL) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    if ((fd = open(path, O_CREATE | O_TRUNC | O_RDWR)) < 0) {
+        printf("cannot create %s\n", path);
+        exit(1);
+    }
+
+    sha256_init(&ctx);
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < size; j++)
+            buf[j] = i * 13 + j * 7;
+        if (write(fd, buf, size) != size) {
+            printf("write to %s failed\n", path);
+            exit(1);
+        }
+        sha256_update(&ctx, (uchar *)buf, size);
+
+        start = rdtime();
+        if (sha256fd(fd, 0, -1, hash) < 0) {
+            printf("SHA-256 fd system call failed\n");
+            exit(1);
+        }
+        elapsed = rdtime() - start;
+
+        tmp = ctx;
+        sha256_final(&tmp, expect);
+        if (memcmp(expect, hash, 32) != 0)
+            printf("digest mismatch after %d bytes\n", (i + 1) * size);
+        printf("%d bytes: %d us\n", (i + 1) * size, (int)(elapsed * 1000000 / TIMER_HZ));
+    }
+
+    close(fd);
+    free(buf);
+}
+
+// Hash count records of size bytes, first with one sha256encrypt
+// call per record and then through the hashing ring: requests are
+// posted to the shared submission queue, the doorbell is rung only
+// when no completion is waiting, and completions are reaped from
+// shared memory. Prints records per second for each, and doorbell
+// system calls per ring pass.
+void bench_ring(int count, int size) {
+    char *buf = bench_records(count, size);
+    uchar *hashes = bench_alloc(count * 32);
+    uchar *ring_hashes = bench_alloc(count * 32);
+    struct sha256_ring *ring = sha256ring();
+    struct sha256_sqe *sqe;
+    struct sha256_cqe *cqe;
+    struct bench_timer t;
+    int doorbells, passes, posted, reaped;
+
+    if (ring == (struct sha256_ring *)-1) {
+        printf("sha256ring failed\n");
+        exit(1);
+    }
+
+    bench_percall(buf, count, size, hashes);
+
+    doorbells = passes = 0;
+    bench_start(&t);
+    do {
+        posted = reaped = 0;
+        while (reaped < count) {
+            while (posted < count && posted - reaped < SHA256_RING_CQ &&
+                   ring->sq_tail - ring->sq_head < SHA256_RING_SQ) {
+                sqe = &ring->sq[ring->sq_tail % SHA256_RING_SQ];
+                sqe->input = (uint64)(buf + posted * size);
+                sqe->len = size;
+                sqe->user_data = posted++;
+                __sync_synchronize();
+                ring->sq_tail++;
+            }
+            if (ring->cq_head == ring->cq_tail) {
+                if (sha256ringenter(1) < 0) {
+                    printf("sha256ringenter failed\n");
+                    exit(1);
+                }
+                doorbells++;
+            }
+            while (ring->cq_head != ring->cq_tail) {
+                __sync_synchronize();
+                cqe = &ring->cq[ring->cq_head % SHA256_RING_CQ];
+                if (cqe->status < 0) {
+                    printf("ring request %d failed\n", (int)cqe->user_data);
+                    exit(1);
+                }
+                memcpy(ring_hashes + cqe->user_data * 32, cqe->digest, 32);
+                ring->cq_head++;
+                reaped++;
+            }
+        }
+        passes++;
+    } while (bench_next(&t, count));
+    printf("ring     %d x %d bytes: %d records/sec, %d doorbells/pass\n", count, size,
+           (int)bench_rate(&t), doorbells / passes);
+
+    if (memcmp(hashes, ring_hashes, count * 32) != 0)
+        printf("digest mismatch in ring of %d x %d bytes\n", count, size);
+
+    free(buf);
+    free(hashes);
+    free(ring_hashes);
+}
+
+// Stream count chunks of size bytes into a kernel hash context, one
+// write() each, the way a process hashes data it produces piece by
+// piece. After each chunk a clone of the context is read for the
+// digest of the prefix so far, which must match the user library,
+// while the original carries on. Prints the time per chunk.
+void bench_stream(int count, int size) {
+    char *buf = malloc(size > 0 ? size : 1);
+    uchar expect[32], hash[32];
+    struct sha256_ctx ctx, tmp;
+    uint64 start, elapsed = 0;
+    int fd, cfd;
+
+    if (buf == NULL) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    if ((fd = sha256open()) < 0) {
+        printf("sha256open failed\n");
+        exit(1);
+    }
+
+    sha256_init(&ctx);
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < size; j++)
+            buf[j] = i * 13 + j * 7;
+        sha256_update(&ctx, (uchar *)buf, size);
+
+        start = rdtime();
+        if (write(fd, buf, size) != size) {
+            printf("write to hash context failed\n");
+            exit(1);
+        }
+        elapsed += rdtime() - start;
+
+        if ((cfd = sha256clone(fd)) < 0 || read(cfd, hash, 32) != 32) {
+            printf("sha256clone failed\n");
+            exit(1);
+        }
+        close(cfd);
+        tmp = ctx;
+        sha256_final(&tmp, expect);
+        if (memcmp(expect, hash, 32) != 0)
+            printf("digest mismatch after %d bytes\n", (i + 1) * size);
+    }
+
+    sha256_final(&ctx, expect);
+    if (read(fd, hash, 32) != 32 || memcmp(expect, hash, 32) != 0)
+        printf("digest mismatch after %d x %d bytes\n", count, size);
+    if (read(fd, hash, 32) != 0)
+        printf("hash context read past its digest\n");
+    printf("streamed %d x %d bytes: %d us/chunk\n", count, size,
+           count > 0 ? (int)(elapsed * 1000000 / TIMER_HZ / count) : 0);
+
+    close(fd);
+    free(buf);
+}
+
+// With arguments, benchmark each given size in bytes, e.g.
+// "sha256sys 1024 65536 10485760", or with "-b count size" compare
+// per-call and batched hashing of count small records, or with
+// "-s count size" measure batched hashing on 1..N harts, or with
+// "-t size" tree-hash on 1..N harts, or with "-v" sweep the lockstep
+// lane count and message size, or with "-h count size" compare ways
+// of computing HMACs, or with "-p iterations" time PBKDF2 on 1..N
+// harts, or with "-f file" time cached whole-file digests, or with
+// "-a file count size" time digests of a growing file, or with
+// "-r count size" compare per-call hashing with the hashing ring, or
+// with "-k count size" stream chunks into a kernel hash context.
+// Without, hash one line of input.
+int main(int argc, char *argv[]) {
+    if (argc == 4 && strcmp(argv[1], "-b") == 0) {
+        bench_batch(atoi(argv[2]), atoi(argv[3]));
+        exit(0);
+    }
+    if (argc == 4 && strcmp(argv[1], "-s") == 0) {
+        bench_scaling(atoi(argv[2]), atoi(argv[3]));
+        exit(0);
+    }
+    if (argc == 3 && strcmp(argv[1], "-t") == 0) {
+        bench_tree(atoi(argv[2]));
+        exit(0);
+    }
+    if (argc == 2 && strcmp(argv[1], "-v") == 0) {
+        bench_lanes();
+        exit(0);
+    }
+    if (argc == 4 && strcmp(argv[1], "-h") == 0) {
+        bench_hmac(atoi(argv[2]), atoi(argv[3]));
+        exit(0);
+    }
+    if (argc == 3 && strcmp(argv[1], "-p") == 0) {
+        bench_pbkdf2(atoi(argv[2]));
+        exit(0);
+    }
+    if (argc == 3 && strcmp(argv[1], "-f") == 0) {
+        bench_file(argv[2]);
+        exit(0);
+    }
+    if (argc == 4 && strcmp(argv[1], "-r") == 0) {
+        bench_ring(atoi(argv[2]), atoi(argv[3]));
+        exit(0);
+    }
+    if (argc == 4 && strcmp(argv[1], "-k") == 0) {
+        bench_stream(atoi(argv[2]), atoi(argv[3]));
+        exit(0);
+    }
+    if (argc == 5 && strcmp(argv[1], "-a") == 0) {
+        bench_append(argv[2], atoi(argv[3]), atoi(argv[4]));
+        exit(0);
+    }
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++)
+            bench(atoi(argv[i]));
+        exit(0);
+    }
+
     printf("Enter the input string (press Enter to submit):\n");
 
     size_t buffer_size = 1024;
@@ -48,7 +753,7 @@ int main() {
     while ((c = getchar()) != -1 && c != '\n') { // Use -1 for EOF in xv6
         if (input_len + 1 >= buffer_size) {
             buffer_size *= 2;
-            input = realloc(input, buffer_size); // Use custom realloc
+            input = realloc(input, buffer_size / 2, buffer_size); // Use custom realloc
             if (input == NULL) {
                 printf("Memory reallocation failed!\n");
                 exit(1);
@@ -102,6 +102,22 @@ extern uint64 sys_link(void);
 extern uint64 sys_mkdir(void);
 extern uint64 sys_close(void);
 extern uint64 sys_sha256encrypt(void);
+extern uint64 sys_sha256direct(void);
+extern uint64 sys_sha256fd(void);
+extern uint64 sys_sha256batch(void);
+extern uint64 sys_sha256ctl(void);
+extern uint64 sys_sha256tree(void);
+extern uint64 sys_sha256caps(void);
+extern uint64 sys_sha256hmackey(void);
+extern uint64 sys_sha256hmac(void);
+extern uint64 sys_sha256pbkdf2(void);
+extern uint64 sys_hrtime(void);
+extern uint64 sys_sha256stats(void);
+extern uint64 sys_kprof(void);
+extern uint64 sys_sha256ring(void);
+extern uint64 sys_sha256ringenter(void);
+extern uint64 sys_sha256open(void);
+extern uint64 sys_sha256clone(void);
 
 // An array mapping syscall numbers from syscall.h
 // to the function that handles the system call.
@@ -128,6 +144,22 @@ static uint64 (*syscalls[])(void) = {
 [SYS_mkdir]        sys_mkdir,
 [SYS_close]        sys_close,
 [SYS_sha256encrypt]  sys_sha256encrypt,
+[SYS_sha256direct]   sys_sha256direct,
+[SYS_sha256fd]       sys_sha256fd,
+[SYS_sha256batch]    sys_sha256batch,
+[SYS_sha256ctl]      sys_sha256ctl,
+[SYS_sha256tree]     sys_sha256tree,
+[SYS_sha256caps]     sys_sha256caps,
+[SYS_sha256hmackey]  sys_sha256hmackey,
+[SYS_sha256hmac]     sys_sha256hmac,
+[SYS_sha256pbkdf2]   sys_sha256pbkdf2,
+[SYS_hrtime]         sys_hrtime,
+[SYS_sha256stats]    sys_sha256stats,
+[SYS_kprof]          sys_kprof,
+[SYS_sha256ring]     sys_sha256ring,
+[SYS_sha256ringenter] sys_sha256ringenter,
+[SYS_sha256open]     sys_sha256open,
+[SYS_sha256clone]    sys_sha256clone,
 };
 
 void
@@ -21,3 +21,19 @@
 #define SYS_mkdir  20
 #define SYS_close  21
 #define SYS_sha256encrypt 22
+#define SYS_sha256direct 23
+#define SYS_sha256fd 24
+#define SYS_sha256batch 25
+#define SYS_sha256ctl 26
+#define SYS_sha256tree 27
+#define SYS_sha256caps 28
+#define SYS_sha256hmackey 29
+#define SYS_sha256hmac 30
+#define SYS_sha256pbkdf2 31
+#define SYS_hrtime 32
+#define SYS_sha256stats 33
+#define SYS_kprof 34
+#define SYS_sha256ring 35
+#define SYS_sha256ringenter 36
+#define SYS_sha256open 37
+#define SYS_sha256clone 38
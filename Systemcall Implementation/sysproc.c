@@ -5,6 +5,13 @@
 #include "memlayout.h"
 #include "spinlock.h"
 #include "proc.h"
+#include "fs.h"
+#include "sleeplock.h"
+#include "file.h"
+#include "sha256.h"
+#include "hashq.h"
+#include "hashstat.h"
+#include "prof.h"
 #include <stdint.h>
 
 uint64
@@ -93,135 +100,45 @@ sys_uptime(void)
   return xticks;
 }
 
+// return the time CSR in nanoseconds since boot, for timing
+// intervals far shorter than a tick.
+uint64
+sys_hrtime(void)
+{
+  return r_time() * (1000000000 / TIMER_HZ);
+}
 
-// Constants for SHA-256
-static const uint K[64] = {
-    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
-    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
-    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
-    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
-    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
-    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
-    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
-    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
-    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-};
-
-// Initial hash values (H0, H1, ..., H7)
-static uint H[8] = {
-    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
-    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
-};
+// control the kernel sampling profiler; see PROF_* in prof.h.
+uint64
+sys_kprof(void)
+{
+  int op, n;
+  uint64 addr;
 
-// Helper function for right rotation
-static uint right_rotate(uint value, unsigned int count) {
-    return (value >> count) | (value << (32 - count));
-}
-
-// SHA-256 transformation (main calculation for each block)
-static void sha256_transform(uint *state, const uchar *block) {
-    uint W[64];
-    uint a, b, c, d, e, f, g, h;
-
-    // Prepare message schedule
-    for (int i = 0; i < 16; ++i) {
-        W[i] = (block[i * 4] << 24) | (block[i * 4 + 1] << 16) |
-               (block[i * 4 + 2] << 8) | block[i * 4 + 3];
-    }
-
-    for (int i = 16; i < 64; ++i) {
-        uint s0 = right_rotate(W[i - 15], 7) ^ right_rotate(W[i - 15], 18) ^ (W[i - 15] >> 3);
-        uint s1 = right_rotate(W[i - 2], 17) ^ right_rotate(W[i - 2], 19) ^ (W[i - 2] >> 10);
-        W[i] = W[i - 16] + s0 + W[i - 7] + s1;
-    }
-
-    // Initialize working variables
-    a = state[0];
-    b = state[1];
-    c = state[2];
-    d = state[3];
-    e = state[4];
-    f = state[5];
-    g = state[6];
-    h = state[7];
-
-    // Main computation loop
-    for (int i = 0; i < 64; ++i) {
-        uint S1 = right_rotate(e, 6) ^ right_rotate(e, 11) ^ right_rotate(e, 25);
-        uint ch = (e & f) ^ (~e & g);
-        uint temp1 = h + S1 + ch + K[i] + W[i];
-        uint S0 = right_rotate(a, 2) ^ right_rotate(a, 13) ^ right_rotate(a, 22);
-        uint maj = (a & b) ^ (a & c) ^ (b & c);
-        uint temp2 = S0 + maj;
-
-        h = g;
-        g = f;
-        f = e;
-        e = d + temp1;
-        d = c;
-        c = b;
-        b = a;
-        a = temp1 + temp2;
-    }
-
-    // Add the compressed chunk to the current state
-    state[0] += a;
-    state[1] += b;
-    state[2] += c;
-    state[3] += d;
-    state[4] += e;
-    state[5] += f;
-    state[6] += g;
-    state[7] += h;
-}
-
-// SHA-256 hashing function
-void sha256encrypt(const uchar *input, uint len, uchar *output) {
-    uint state[8];
-    uchar block[64];
-    uint i, j;
-
-    for (i = 0; i < 8; ++i) state[i] = H[i];
-
-    // Process complete 64-byte blocks
-    for (i = 0; i + 64 <= len; i += 64) {
-        sha256_transform(state, input + i);
-    }
-
-    // Handle padding for the last block
-    j = len % 64;
-    for (int k = 0; k < j; ++k) block[k] = input[i + k];
-    block[j++] = 0x80;
-    if (j > 56) {
-        while (j < 64) block[j++] = 0;
-        sha256_transform(state, block);
-        j = 0;
-    }
-    while (j < 56) block[j++] = 0;
-    unsigned long bit_len = len * 8;
-    for (int k = 0; k < 8; ++k) block[63 - k] = (bit_len >> (k * 8)) & 0xff;
-    sha256_transform(state, block);
-
-    // Output the final hash
-    for (i = 0; i < 8; ++i) {
-        output[i * 4] = (state[i] >> 24) & 0xff;
-        output[i * 4 + 1] = (state[i] >> 16) & 0xff;
-        output[i * 4 + 2] = (state[i] >> 8) & 0xff;
-        output[i * 4 + 3] = state[i] & 0xff;
-    }
+  argint(0, &op);
+  argaddr(1, &addr);
+  argint(2, &n);
+  return profctl(op, addr, n);
 }
 
+
 // System call to compute SHA-256
+// Input of any length is copied in and compressed one page at a
+// time, so the kernel never holds more than a page of it.
+// Cycles spent in each phase are added to this hart's counters
+// (hashstat.c); usertrap() adds the trap phase around the call.
 uint64 sys_sha256encrypt(void) {
     uint64 input, output;
-    int len;
+    int len, off, n;
+    struct sha256_ctx ctx;
+    char *buf;
+    char hash[32];   // Fixed hash size for SHA-256
+    struct proc *p = myproc();
+    uint64 t, copyin_cycles = 0, transform_cycles = 0;
+    int hart, r = -1;
+
+    // usertrap() adds the way out and counts the call
+    p->hashtrap = hashstat_since(p->hashcycles, p->hashhart);
 
     // Retrieve arguments
     argaddr(0, &input);  // Input buffer address
@@ -229,26 +146,586 @@ uint64 sys_sha256encrypt(void) {
     argaddr(2, &output); // Output buffer address
 
     // Validate arguments manually
-    if (input == 0 || len <= 0 || len > 1024 || output == 0 || input >= MAXVA || output >= MAXVA) {
-        return -1; // Invalid arguments
+    if (len < 0 || output == 0 || output >= MAXVA ||
+        (len > 0 && (input == 0 || input >= MAXVA))) {
+        goto out; // Invalid arguments
     }
 
-    // Allocate kernel buffers
-    char buf[1024];  // Maximum input size
-    char hash[32];   // Fixed hash size for SHA-256
-
-    // Copy input data from user space to kernel space
-    if (copyin(myproc()->pagetable, buf, input, len) < 0) {
-        return -1; // Failed to copy input
+    // One page of bounce buffer, rather than the 4 KB kernel stack
+    if ((buf = kalloc()) == 0) {
+        goto out; // Out of memory
     }
 
-    // Perform SHA-256 computation
-    sha256encrypt((uchar *)buf, len, (uchar *)hash);
+    sha256_init(&ctx);
+    for (off = 0; off < len; off += n) {
+        n = len - off;
+        if (n > PGSIZE)
+            n = PGSIZE;
+
+        // Copy the next chunk from user space to kernel space
+        hashstat_mark(&t, &hart);
+        if (copyin(p->pagetable, buf, input + off, n) < 0) {
+            kfree(buf);
+            goto out; // Failed to copy input
+        }
+        hashstat_acc(&copyin_cycles, hashstat_since(t, hart));
+
+        hashstat_mark(&t, &hart);
+        sha256_update(&ctx, (uchar *)buf, n);
+        hashstat_acc(&transform_cycles, hashstat_since(t, hart));
+    }
+    kfree(buf);
+    hashstat_mark(&t, &hart);
+    sha256_final(&ctx, (uchar *)hash);
+    hashstat_acc(&transform_cycles, hashstat_since(t, hart));
+    hashstat_add(SHA256_PH_COPYIN, 1, len, copyin_cycles);
+    hashstat_add(SHA256_PH_TRANSFORM, 1, len, transform_cycles);
 
     // Copy the hash result back to user space
+    hashstat_mark(&t, &hart);
+    if (copyout(p->pagetable, output, hash, 32) < 0) {
+        goto out; // Failed to copy output
+    }
+    hashstat_add(SHA256_PH_COPYOUT, 1, 32, hashstat_since(t, hart));
+
+    r = 0; // Success
+out:
+    hashstat_mark(&p->hashcycles, &p->hashhart);
+    return r;
+}
+
+// Zero-copy variant of sys_sha256encrypt: the user's pages are
+// hashed where they are, with no bounce buffer.
+uint64 sys_sha256direct(void) {
+    uint64 input, output;
+    int len;
+    struct sha256_ctx ctx;
+    char hash[32];
+
+    argaddr(0, &input);
+    argint(1, &len);
+    argaddr(2, &output);
+
+    if (len < 0 || output == 0 || output >= MAXVA ||
+        (len > 0 && (input == 0 || input >= MAXVA))) {
+        return -1;
+    }
+
+    sha256_init(&ctx);
+    if (sha256_uvm(myproc()->pagetable, &ctx, input, len) < 0) {
+        return -1; // Part of the input is not mapped
+    }
+    sha256_final(&ctx, (uchar *)hash);
+
     if (copyout(myproc()->pagetable, output, hash, 32) < 0) {
-        return -1; // Failed to copy output
+        return -1;
+    }
+
+    return 0;
+}
+
+// Hash len bytes of an open file starting at byte off, or everything
+// from off to the end of the file if len is negative. The data is
+// hashed out of the buffer cache, so it never visits user memory.
+// Whole-file digests are kept in the digest cache (hcache.c) and
+// served from there until the file changes. The inode also keeps the
+// midstate of the file's whole blocks, so the next whole digest of a
+// file that has only grown hashes just the new bytes.
+// The file offset is left untouched.
+// Returns the number of bytes hashed.
+uint64 sys_sha256fd(void) {
+    int fd, len, off, n, whole, skip, i;
+    uint64 output;
+    struct file *f;
+    struct sha256_ctx ctx;
+    char hash[32];
+
+    argint(0, &fd);
+    argint(1, &off);
+    argint(2, &len);
+    argaddr(3, &output);
+
+    if (fd < 0 || fd >= NOFILE || (f = myproc()->ofile[fd]) == 0)
+        return -1;
+    if (f->type != FD_INODE || !f->readable || off < 0)
+        return -1;
+    if (output == 0 || output >= MAXVA)
+        return -1;
+
+    sha256_init(&ctx);
+    ilock(f->ip);
+    if (off > f->ip->size) {
+        iunlock(f->ip);
+        return -1;
+    }
+    if (len < 0 || len > f->ip->size - off)
+        len = f->ip->size - off;
+    whole = off == 0 && len == f->ip->size;
+    if (whole && hcacheget(f->ip, (uchar *)hash) == 0) {
+        iunlock(f->ip);
+        n = len;
+    } else {
+        // A file only appended to since its last whole digest
+        // resumes from the saved midstate.
+        skip = 0;
+        if (whole && f->ip->hashlen > 0 && f->ip->hashlen <= len) {
+            for (i = 0; i < 8; i++)
+                ctx.state[i] = f->ip->hashstate[i];
+            ctx.len = skip = f->ip->hashlen;
+        }
+        n = sha256inode(f->ip, &ctx, off + skip, len - skip);
+        if (n != len - skip) {
+            iunlock(f->ip);
+            return -1; // Ran into a hole the disk could not fill
+        }
+        n = len;
+        if (whole) {
+            for (i = 0; i < 8; i++)
+                f->ip->hashstate[i] = ctx.state[i];
+            f->ip->hashlen = ctx.len - ctx.len % SHA256_BLOCK_SIZE;
+        }
+        sha256_final(&ctx, (uchar *)hash);
+        if (whole)
+            hcacheput(f->ip, (uchar *)hash);
+        iunlock(f->ip);
+    }
+
+    if (copyout(myproc()->pagetable, output, hash, 32) < 0)
+        return -1;
+
+    return n;
+}
+
+// Number of messages sys_sha256batch handles per round
+#define BATCH_CHUNK 32
+
+// sys_sha256batch's working set, one page
+struct batchpage {
+    struct sha256_desc desc[BATCH_CHUNK];
+    struct hashjob job[BATCH_CHUNK];
+    uchar hash[BATCH_CHUNK][32];
+};
+
+// If every message in a round has this length and they fit in one
+// page, copy them into a staging page and hash them in lockstep
+// with sha256_multi. Returns the byte stride used, or 0 if the
+// round has to go through the workers.
+static uint64 batch_stride(struct sha256_desc *desc, int m) {
+    uint64 stride = (desc[0].len + 3) & ~3; // vector loads want aligned words
+
+    if (m < 2 || desc[0].len == 0 || stride * m > PGSIZE)
+        return 0;
+    for (int j = 1; j < m; j++)
+        if (desc[j].len != desc[0].len)
+            return 0;
+    return stride;
+}
+
+// Hash n independent messages described by an array of
+// struct sha256_desc in one trap. A round of short messages of one
+// length is hashed in lockstep, one per vector lane where the hart
+// has them; any other round is spread over the hashing workers on
+// all harts, which read the messages in place from the user's
+// pages. The digests are then copied out to each desc.output.
+// Returns n, or -1 if any descriptor or buffer is bad.
+uint64 sys_sha256batch(void) {
+    uint64 descs, stride;
+    int n, i, j, m;
+    struct batchpage *bp;
+    char *stage = 0;
+    struct hashgroup group;
+    pagetable_t pagetable = myproc()->pagetable;
+
+    argaddr(0, &descs);
+    argint(1, &n);
+
+    if (n < 0 || (n > 0 && (descs == 0 || descs >= MAXVA)))
+        return -1;
+
+    if ((bp = (struct batchpage *)kalloc()) == 0)
+        return -1;
+
+    for (i = 0; i < n; i += m) {
+        m = n - i;
+        if (m > BATCH_CHUNK)
+            m = BATCH_CHUNK;
+        if (copyin(pagetable, (char *)bp->desc, descs + i * sizeof(bp->desc[0]),
+                   m * sizeof(bp->desc[0])) < 0)
+            goto bad;
+
+        for (j = 0; j < m; j++) {
+            if (bp->desc[j].output == 0 || bp->desc[j].output >= MAXVA)
+                goto bad;
+        }
+
+        if ((stride = batch_stride(bp->desc, m)) != 0) {
+            if (stage == 0 && (stage = kalloc()) == 0)
+                goto bad;
+            for (j = 0; j < m; j++) {
+                if (copyin(pagetable, stage + j * stride, bp->desc[j].input, bp->desc[j].len) < 0)
+                    goto bad;
+            }
+            sha256_multi((uchar *)stage, stride, bp->desc[0].len, m, bp->hash[0]);
+        } else {
+            for (j = 0; j < m; j++) {
+                bp->job[j].pagetable = pagetable;
+                bp->job[j].input = bp->desc[j].input;
+                bp->job[j].len = bp->desc[j].len;
+                bp->job[j].output = bp->hash[j];
+                bp->job[j].leaf = 0;
+                bp->job[j].run = 0;
+            }
+            hashqsubmit(&group, bp->job, m);
+            if (hashqwait(&group) < 0)
+                goto bad;
+        }
+
+        for (j = 0; j < m; j++) {
+            if (copyout(pagetable, bp->desc[j].output, (char *)bp->hash[j], 32) < 0)
+                goto bad;
+        }
     }
 
-    return 0; // Success
+    if (stage)
+        kfree(stage);
+    kfree(bp);
+    return n;
+
+bad:
+    if (stage)
+        kfree(stage);
+    kfree(bp);
+    return -1;
+}
+
+// Leaves sys_sha256tree hashes per round
+#define TREE_CHUNK 32
+
+// sys_sha256tree's working set, one page
+struct treepage {
+    struct hashjob job[TREE_CHUNK];
+    uchar hash[TREE_CHUNK][32];
+    struct sha256_tree tree;
+};
+
+// Tree-hash len bytes of user memory (see sha256.h for the format).
+// Each round's leaves are hashed in parallel by the hashing workers
+// and then added to the tree in order.
+uint64 sys_sha256tree(void) {
+    uint64 input, output, off, nleaves, leaf, i;
+    int len, m;
+    struct treepage *tp;
+    struct hashgroup group;
+    char root[32];
+    pagetable_t pagetable = myproc()->pagetable;
+
+    argaddr(0, &input);
+    argint(1, &len);
+    argaddr(2, &output);
+
+    if (len < 0 || output == 0 || output >= MAXVA ||
+        (len > 0 && (input == 0 || input >= MAXVA))) {
+        return -1;
+    }
+
+    if ((tp = (struct treepage *)kalloc()) == 0)
+        return -1;
+
+    // An empty input is one empty leaf
+    nleaves = len == 0 ? 1 : (len + SHA256_TREE_LEAF - 1) / SHA256_TREE_LEAF;
+    sha256_tree_init(&tp->tree);
+    for (leaf = 0; leaf < nleaves; leaf += m) {
+        m = nleaves - leaf;
+        if (m > TREE_CHUNK)
+            m = TREE_CHUNK;
+        for (i = 0; i < m; i++) {
+            off = (leaf + i) * SHA256_TREE_LEAF;
+            tp->job[i].pagetable = pagetable;
+            tp->job[i].input = input + off;
+            tp->job[i].len = len - off < SHA256_TREE_LEAF ? len - off : SHA256_TREE_LEAF;
+            tp->job[i].output = tp->hash[i];
+            tp->job[i].leaf = 1;
+            tp->job[i].run = 0;
+        }
+
+        hashqsubmit(&group, tp->job, m);
+        if (hashqwait(&group) < 0) {
+            kfree(tp);
+            return -1;
+        }
+        for (i = 0; i < m; i++)
+            sha256_tree_add(&tp->tree, tp->hash[i]);
+    }
+    sha256_tree_final(&tp->tree, (uchar *)root);
+    kfree(tp);
+
+    if (copyout(pagetable, output, root, 32) < 0)
+        return -1;
+
+    return 0;
+}
+
+// Tune and query the kernel hashing engine; see SHA256_CTL_*
+// in sha256.h.
+uint64 sys_sha256ctl(void) {
+    int op, arg;
+    uint64 hits, misses;
+
+    argint(0, &op);
+    argint(1, &arg);
+
+    switch (op) {
+    case SHA256_CTL_WORKERS:
+        return hashqworkers(arg);
+    case SHA256_CTL_NWORKERS:
+        return hashqnworkers();
+    case SHA256_CTL_LANES:
+        return sha256_multi_lanes(arg);
+    case SHA256_CTL_HMACDEL:
+        return hmacdel(arg);
+    case SHA256_CTL_CACHEHITS:
+        hcachestats(&hits, &misses, 0);
+        return hits;
+    case SHA256_CTL_CACHEMISSES:
+        hcachestats(&hits, &misses, 0);
+        return misses;
+    case SHA256_CTL_CACHERESET:
+        hcachestats(&hits, &misses, 1);
+        return 0;
+    case SHA256_CTL_SELFTEST:
+        return sha256_selftest_result();
+    case SHA256_CTL_SELFTESTCYCLES:
+        return sha256_selftest_cycles();
+    }
+    return -1;
+}
+
+// Report the SHA256_CAP_* features the kernel found at boot, so
+// user programs can pick the same SHA-256 backend.
+uint64 sys_sha256caps(void) {
+    return sha256caps();
+}
+
+// Prepare the HMAC key of len bytes at user address key. Keys
+// longer than a block are hashed in place from user memory, as HMAC
+// requires.
+static int hmac_userkey(pagetable_t pagetable, uint64 key, int len, struct sha256_hmac_key *hk) {
+    uchar k[SHA256_BLOCK_SIZE];
+    struct sha256_ctx ctx;
+
+    if (len < 0 || (len > 0 && (key == 0 || key >= MAXVA)))
+        return -1;
+
+    if (len > SHA256_BLOCK_SIZE) {
+        sha256_init(&ctx);
+        if (sha256_uvm(pagetable, &ctx, key, len) < 0)
+            return -1;
+        sha256_final(&ctx, k);
+        len = SHA256_DIGEST_SIZE;
+    } else if (copyin(pagetable, (char *)k, key, len) < 0) {
+        return -1;
+    }
+
+    sha256_hmac_setkey(hk, k, len);
+    memset(k, 0, sizeof(k));
+    return 0;
+}
+
+// Register an HMAC key of len bytes. Only its midstates are kept,
+// in the kernel key table.
+// Returns the key's number for sha256hmac(), or -1.
+uint64 sys_sha256hmackey(void) {
+    uint64 key;
+    int len, id;
+    struct sha256_hmac_key hk;
+
+    argaddr(0, &key);
+    argint(1, &len);
+
+    if (hmac_userkey(myproc()->pagetable, key, len, &hk) < 0)
+        return -1;
+    id = hmacadd(&hk);
+    memset(&hk, 0, sizeof(hk));
+    return id;
+}
+
+// MAC len bytes of user memory under registered key id. The message
+// is read in place; the key's blocks are never hashed again.
+uint64 sys_sha256hmac(void) {
+    uint64 input, output;
+    int id, len;
+    uchar mac[SHA256_DIGEST_SIZE];
+    struct sha256_ctx ctx;
+    struct sha256_hmac_key hk;
+    pagetable_t pagetable = myproc()->pagetable;
+    int r = -1;
+
+    argint(0, &id);
+    argaddr(1, &input);
+    argint(2, &len);
+    argaddr(3, &output);
+
+    if (len < 0 || output == 0 || output >= MAXVA ||
+        (len > 0 && (input == 0 || input >= MAXVA))) {
+        return -1;
+    }
+    if (hmacget(id, &hk) < 0)
+        return -1;
+
+    sha256_hmac_init(&ctx, &hk);
+    if (sha256_uvm(pagetable, &ctx, input, len) < 0)
+        goto out;
+    sha256_hmac_final(&ctx, &hk, mac);
+
+    if (copyout(pagetable, output, (char *)mac, SHA256_DIGEST_SIZE) < 0)
+        goto out;
+    r = 0;
+out:
+    // the midstates are as good as the key
+    memset(&hk, 0, sizeof(hk));
+    memset(&ctx, 0, sizeof(ctx));
+    return r;
+}
+
+#define PBKDF2_BLOCKS (SHA256_PBKDF2_MAXOUT / SHA256_DIGEST_SIZE)
+
+// sys_sha256pbkdf2's working set, one page
+struct pbkdf2page {
+    struct hashjob job[PBKDF2_BLOCKS];
+    struct pbkdf2arg {
+        struct pbkdf2page *pp;
+        uint index;
+    } arg[PBKDF2_BLOCKS];
+    uchar out[PBKDF2_BLOCKS][SHA256_DIGEST_SIZE];
+    uchar salt[SHA256_PBKDF2_MAXSALT];
+    struct sha256_hmac_key key;
+    uint saltlen;
+    uint iterations;
+};
+
+// Derive one output block on a hashing worker.
+static int pbkdf2run(struct hashjob *j) {
+    struct pbkdf2arg *a = (struct pbkdf2arg *)j->input;
+    struct pbkdf2page *pp = a->pp;
+
+    sha256_pbkdf2_block(&pp->key, pp->salt, pp->saltlen, pp->iterations, a->index, j->output);
+    return 0;
+}
+
+// Derive a key with PBKDF2-HMAC-SHA256 as described by a struct
+// sha256_pbkdf2_args. The password's HMAC midstates are computed
+// once, and each 32-byte output block is derived by a hashing
+// worker, so a long key uses several harts.
+// Returns 0, or -1 if the arguments are bad or a block failed.
+uint64 sys_sha256pbkdf2(void) {
+    uint64 uargs;
+    struct sha256_pbkdf2_args args;
+    struct pbkdf2page *pp;
+    struct hashgroup group;
+    int i, n, r;
+    pagetable_t pagetable = myproc()->pagetable;
+
+    argaddr(0, &uargs);
+    if (copyin(pagetable, (char *)&args, uargs, sizeof(args)) < 0)
+        return -1;
+    if (args.iterations == 0 || args.iterations > SHA256_PBKDF2_MAXITER ||
+        args.outlen == 0 || args.outlen > SHA256_PBKDF2_MAXOUT ||
+        args.saltlen > SHA256_PBKDF2_MAXSALT ||
+        args.output == 0 || args.output >= MAXVA)
+        return -1;
+
+    if ((pp = (struct pbkdf2page *)kalloc()) == 0)
+        return -1;
+    if (copyin(pagetable, (char *)pp->salt, args.salt, args.saltlen) < 0 ||
+        hmac_userkey(pagetable, args.password, args.passlen, &pp->key) < 0) {
+        kfree(pp);
+        return -1;
+    }
+    pp->saltlen = args.saltlen;
+    pp->iterations = args.iterations;
+
+    n = (args.outlen + SHA256_DIGEST_SIZE - 1) / SHA256_DIGEST_SIZE;
+    for (i = 0; i < n; i++) {
+        pp->arg[i].pp = pp;
+        pp->arg[i].index = i + 1;
+        pp->job[i].pagetable = 0;
+        pp->job[i].input = (uint64)&pp->arg[i];
+        pp->job[i].len = (uint64)args.iterations * 2 * SHA256_BLOCK_SIZE;
+        pp->job[i].output = pp->out[i];
+        pp->job[i].leaf = 0;
+        pp->job[i].run = pbkdf2run;
+    }
+    hashqsubmit(&group, pp->job, n);
+    if (hashqwait(&group) < 0) {
+        memset(&pp->key, 0, sizeof(pp->key));
+        kfree(pp);
+        return -1;
+    }
+
+    r = copyout(pagetable, args.output, (char *)pp->out, args.outlen);
+    memset(&pp->key, 0, sizeof(pp->key));
+    kfree(pp);
+    return r < 0 ? -1 : 0;
+}
+
+// Copy the sha256encrypt() phase counters of the first n harts to
+// the array of struct sha256_stats at st, zeroing every hart's
+// counters afterwards if reset is set.
+// Returns the number of harts, NCPU, so a caller can size st.
+uint64 sys_sha256stats(void) {
+    uint64 st;
+    int n, reset, i;
+    struct sha256_stats s;
+
+    argaddr(0, &st);
+    argint(1, &n);
+    argint(2, &reset);
+
+    if (n < 0 || (n > 0 && (st == 0 || st >= MAXVA)))
+        return -1;
+    if (n > NCPU)
+        n = NCPU;
+
+    for (i = 0; i < NCPU; i++) {
+        hashstat_read(i, &s, reset);
+        if (i < n && copyout(myproc()->pagetable, st + i * sizeof(s), (char *)&s, sizeof(s)) < 0)
+            return -1;
+    }
+    return NCPU;
+}
+
+// Map a hashing ring (hashring.c) into the calling process.
+// Returns its user address, the same on every call, or -1.
+uint64 sys_sha256ring(void) {
+    return hashringsetup();
+}
+
+// Doorbell for the calling process's ring: have the kernel drain the
+// submission queue, and wait for at least want completions.
+// Returns the number of completions waiting to be reaped.
+uint64 sys_sha256ringenter(void) {
+    int want;
+
+    argint(0, &want);
+    return hashringenter(want);
+}
+
+// Open a kernel hash context (hashfile.c) as a file descriptor.
+// Data written to it is hashed; reading it returns the digest.
+uint64 sys_sha256open(void) {
+    return hashfileopen(0);
+}
+
+// Open a second hash context with the state of the one open on fd.
+// Returns its file descriptor.
+uint64 sys_sha256clone(void) {
+    int fd;
+    struct file *f;
+
+    argint(0, &fd);
+    if (fd < 0 || fd >= NOFILE || (f = myproc()->ofile[fd]) == 0)
+        return -1;
+    if (f->type != FD_HASH)
+        return -1;
+    return hashfileopen(f->hash);
 }
@@ -1,5 +1,9 @@
 #include "../kernel/types.h"
 struct stat;
+struct sha256_desc;
+struct sha256_pbkdf2_args;
+struct sha256_stats;
+struct sha256_ring;
 
 // system calls
 int fork(void);
@@ -25,6 +29,22 @@ char* sbrk(int);
 int sleep(int);
 int uptime(void);
 int sha256encrypt(const char *input, int len, uchar *output);
+int sha256direct(const char *input, int len, uchar *output);
+int sha256fd(int fd, int off, int len, uchar *output);
+int sha256batch(struct sha256_desc *descs, int n);
+int sha256ctl(int op, int arg);
+int sha256tree(const char *input, int len, uchar *output);
+int sha256caps(void);
+int sha256hmackey(const char *key, int len);
+int sha256hmac(int key, const char *input, int len, uchar *mac);
+int sha256pbkdf2(struct sha256_pbkdf2_args *args);
+uint64 hrtime(void);
+int sha256stats(struct sha256_stats *st, int n, int reset);
+int kprof(int op, uint64 *pcs, int n);
+struct sha256_ring *sha256ring(void);
+int sha256ringenter(int want);
+int sha256open(void);
+int sha256clone(int fd);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -44,3 +64,23 @@ void *memcpy(void *, const void *, uint);
 // umalloc.c
 void* malloc(uint);
 void free(void*);
+
+// timing.c
+void print_fixed(int, uint64);
+
+// counters, readable from user mode once start() enables them
+static inline uint64
+rdcycle(void)
+{
+  uint64 x;
+  asm volatile("rdcycle %0" : "=r" (x));
+  return x;
+}
+
+static inline uint64
+rdtime(void)
+{
+  uint64 x;
+  asm volatile("rdtime %0" : "=r" (x));
+  return x;
+}
@@ -37,3 +37,19 @@ entry("sbrk");
 entry("sleep");
 entry("uptime");
 entry("sha256encrypt");
+entry("sha256direct");
+entry("sha256fd");
+entry("sha256batch");
+entry("sha256ctl");
+entry("sha256tree");
+entry("sha256caps");
+entry("sha256hmackey");
+entry("sha256hmac");
+entry("sha256pbkdf2");
+entry("hrtime");
+entry("sha256stats");
+entry("kprof");
+entry("sha256ring");
+entry("sha256ringenter");
+entry("sha256open");
+entry("sha256clone");
@@ -0,0 +1,82 @@
+#include "kernel/types.h"
+#include "user/user.h"
+#include "kernel/sha256.h"
+
+// Dump the kernel's per-hart sha256encrypt() phase counters: one row
+// per phase for every hart that has hashed anything, then the totals
+// over all harts. With -r, the counters are zeroed after reading.
+//   hart phase calls bytes cycles cycles/call cycles/byte
+
+const char *phase_names[SHA256_NPHASES] = { "trap", "copyin", "transform", "copyout" };
+
+// printf has no 64-bit conversion, and cycle counts outgrow an int.
+void print_u64(uint64 v) {
+    if (v >= 10)
+        print_u64(v / 10);
+    printf("%c", '0' + (int)(v % 10));
+}
+
+void print_row(char *hart, int phase, struct sha256_phase *ph) {
+    printf("%s %s ", hart, phase_names[phase]);
+    print_u64(ph->calls);
+    printf(" ");
+    print_u64(ph->bytes);
+    printf(" ");
+    print_u64(ph->cycles);
+    printf(" ");
+    print_u64(ph->calls ? ph->cycles / ph->calls : 0);
+    printf(" ");
+    if (ph->bytes)
+        print_fixed(1, ph->cycles * 100 / ph->bytes);
+    else
+        printf("-");
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    struct sha256_stats *st, total;
+    int reset = 0, nharts, h, i;
+    char name[8];
+
+    if (argc == 2 && strcmp(argv[1], "-r") == 0) {
+        reset = 1;
+    } else if (argc != 1) {
+        printf("Usage: hashstat [-r]\n");
+        exit(1);
+    }
+
+    if ((nharts = sha256stats(0, 0, 0)) < 0) {
+        printf("sha256stats failed\n");
+        exit(1);
+    }
+    if ((st = malloc(nharts * sizeof(*st))) == 0) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    if (sha256stats(st, nharts, reset) < 0) {
+        printf("sha256stats failed\n");
+        exit(1);
+    }
+
+    memset(&total, 0, sizeof(total));
+    printf("hart phase calls bytes cycles cycles/call cycles/byte\n");
+    for (h = 0; h < nharts; h++) {
+        if (st[h].phase[SHA256_PH_TRAP].calls == 0 &&
+            st[h].phase[SHA256_PH_COPYIN].calls == 0)
+            continue;
+        name[0] = '0' + h / 10;
+        name[1] = '0' + h % 10;
+        name[2] = 0;
+        for (i = 0; i < SHA256_NPHASES; i++) {
+            print_row(h < 10 ? name + 1 : name, i, &st[h].phase[i]);
+            total.phase[i].calls += st[h].phase[i].calls;
+            total.phase[i].bytes += st[h].phase[i].bytes;
+            total.phase[i].cycles += st[h].phase[i].cycles;
+        }
+    }
+    for (i = 0; i < SHA256_NPHASES; i++)
+        print_row("all", i, &total.phase[i]);
+
+    free(st);
+    exit(0);
+}
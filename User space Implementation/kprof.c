@@ -0,0 +1,237 @@
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+#include "kernel/fcntl.h"
+#include "kernel/prof.h"
+
+// Run a command under the kernel sampling profiler, then report where
+// the kernel was when the timer interrupted it:
+//   kprof [-n rows] command [args...]
+// Samples are matched against kernel.sym, the kernel's symbol table,
+// which the Makefile puts in the file system. Two tables follow,
+// each with at most rows rows, most samples first: one per kernel
+// function and one per instruction, the latter to be looked up in
+// kernel.asm.
+//   samples percent function
+//   samples percent pc function+offset
+// A timer interrupt held off while the kernel had interrupts
+// disabled is charged to the instruction that enabled them again.
+// The header line counts such late samples, and their rows in the
+// instruction table are marked "late": the time they stand for was
+// spent in whatever ran before, with interrupts off.
+
+#define SYMFILE "kernel.sym"
+
+// Enough for PROFNSAMPLE samples on each of NCPU harts
+#define MAXSAMPLES (NCPU * PROFNSAMPLE)
+
+struct sym {
+    uint64 addr;
+    char *name;
+    int samples;
+};
+
+struct sym *syms;
+int nsyms;
+
+// Shell sort, which needs no recursion and little code.
+void sort_pcs(uint64 *a, int n) {
+    for (int gap = n / 2; gap > 0; gap /= 2)
+        for (int i = gap; i < n; i++)
+            for (int j = i; j >= gap && a[j - gap] > a[j]; j -= gap) {
+                uint64 t = a[j];
+                a[j] = a[j - gap];
+                a[j - gap] = t;
+            }
+}
+
+void sort_syms(struct sym *a, int n) {
+    for (int gap = n / 2; gap > 0; gap /= 2)
+        for (int i = gap; i < n; i++)
+            for (int j = i; j >= gap && a[j - gap].addr > a[j].addr; j -= gap) {
+                struct sym t = a[j];
+                a[j] = a[j - gap];
+                a[j - gap] = t;
+            }
+}
+
+int hexdigit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+// Read SYMFILE, whose lines are "address name", into syms, sorted by
+// address. Section and file names, and symbols below the kernel's
+// load address, can't be a sample's function and are left out.
+int load_syms(void) {
+    struct stat st;
+    char *text, *p, *name;
+    uint64 addr;
+    int fd, d, max;
+
+    if ((fd = open(SYMFILE, O_RDONLY)) < 0 || fstat(fd, &st) < 0)
+        return -1;
+    if ((text = malloc(st.size + 1)) == 0 || read(fd, text, st.size) != st.size) {
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    text[st.size] = 0;
+
+    max = 0;
+    for (p = text; *p; p++)
+        if (*p == '\n')
+            max++;
+    if ((syms = malloc((max + 1) * sizeof(*syms))) == 0)
+        return -1;
+
+    for (p = text; *p; ) {
+        addr = 0;
+        while ((d = hexdigit(*p)) >= 0) {
+            addr = addr << 4 | d;
+            p++;
+        }
+        while (*p == ' ')
+            p++;
+        name = p;
+        while (*p && *p != '\n')
+            p++;
+        if (*p)
+            *p++ = 0;
+        if (*name == 0 || *name == '.' || addr < 0x80000000L)
+            continue;
+        syms[nsyms].addr = addr;
+        syms[nsyms].name = name;
+        syms[nsyms].samples = 0;
+        nsyms++;
+    }
+    sort_syms(syms, nsyms);
+    return nsyms > 0 ? 0 : -1;
+}
+
+// Print count as a percentage of total, with one decimal.
+void print_percent(int count, int total) {
+    int permille = (int)((uint64)count * 1000 / total);
+    printf("%d.%d", permille / 10, permille % 10);
+}
+
+int main(int argc, char *argv[]) {
+    uint64 *pcs, *upc;
+    int *ucount, *usym;
+    int rows = 20, first = 1, n, m, nuniq, late, i, j, best, pid;
+
+    if (argc >= 3 && strcmp(argv[1], "-n") == 0) {
+        rows = atoi(argv[2]);
+        first = 3;
+    }
+    if (first >= argc) {
+        printf("Usage: kprof [-n rows] command [args...]\n");
+        exit(1);
+    }
+    if (load_syms() < 0) {
+        printf("kprof: cannot read %s\n", SYMFILE);
+        exit(1);
+    }
+    if ((pcs = malloc(MAXSAMPLES * sizeof(*pcs))) == 0) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+
+    if (kprof(PROF_START, 0, 0) < 0) {
+        printf("kprof: cannot start the profiler\n");
+        exit(1);
+    }
+    if ((pid = fork()) < 0) {
+        kprof(PROF_STOP, 0, 0);
+        printf("kprof: fork failed\n");
+        exit(1);
+    }
+    if (pid == 0) {
+        exec(argv[first], argv + first);
+        printf("kprof: exec %s failed\n", argv[first]);
+        exit(1);
+    }
+    wait(0);
+    kprof(PROF_STOP, 0, 0);
+
+    for (n = 0; n < MAXSAMPLES; n += m)
+        if ((m = kprof(PROF_READ, pcs + n, MAXSAMPLES - n)) <= 0)
+            break;
+    late = 0;
+    for (i = 0; i < n; i++)
+        if (pcs[i] & PROF_LATE)
+            late++;
+    printf("# %d kernel samples, %d in user code, %d dropped, %d late\n", n,
+           kprof(PROF_USER, 0, 0), kprof(PROF_DROPPED, 0, 0), late);
+    if (n == 0)
+        exit(0);
+
+    // Count samples per distinct pc, and per function, walking the
+    // sorted pcs and symbols together.
+    sort_pcs(pcs, n);
+    upc = malloc(n * sizeof(*upc));
+    ucount = malloc(n * sizeof(*ucount));
+    usym = malloc(n * sizeof(*usym));
+    if (upc == 0 || ucount == 0 || usym == 0) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    nuniq = 0;
+    j = 0;
+    for (i = 0; i < n; i++) {
+        if (nuniq > 0 && upc[nuniq - 1] == pcs[i]) {
+            ucount[nuniq - 1]++;
+        } else {
+            while (j + 1 < nsyms && syms[j + 1].addr <= pcs[i])
+                j++;
+            upc[nuniq] = pcs[i];
+            ucount[nuniq] = 1;
+            usym[nuniq] = syms[j].addr <= pcs[i] ? j : -1;
+            nuniq++;
+        }
+        if (syms[j].addr <= pcs[i])
+            syms[j].samples++;
+    }
+
+    printf("samples percent function\n");
+    for (i = 0; i < rows; i++) {
+        best = -1;
+        for (j = 0; j < nsyms; j++)
+            if (syms[j].samples > 0 && (best < 0 || syms[j].samples > syms[best].samples))
+                best = j;
+        if (best < 0)
+            break;
+        printf("%d ", syms[best].samples);
+        print_percent(syms[best].samples, n);
+        printf(" %s\n", syms[best].name);
+        syms[best].samples = -syms[best].samples;
+    }
+
+    // Late samples sort next to, but apart from, on-time ones at the
+    // same pc, so each gets its own row.
+    printf("samples percent pc function+offset\n");
+    for (i = 0; i < rows; i++) {
+        best = -1;
+        for (j = 0; j < nuniq; j++)
+            if (ucount[j] > 0 && (best < 0 || ucount[j] > ucount[best]))
+                best = j;
+        if (best < 0)
+            break;
+        uint64 pc = upc[best] & ~(uint64)PROF_LATE;
+        printf("%d ", ucount[best]);
+        print_percent(ucount[best], n);
+        if (usym[best] >= 0)
+            printf(" 0x%x %s+0x%x", (uint)pc, syms[usym[best]].name,
+                   (uint)(pc - syms[usym[best]].addr));
+        else
+            printf(" 0x%x ?", (uint)pc);
+        printf("%s\n", (upc[best] & PROF_LATE) ? " late" : "");
+        ucount[best] = -ucount[best];
+    }
+
+    exit(0);
+}
@@ -0,0 +1,337 @@
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "kernel/sha256.h"
+#include "kernel/fcntl.h"
+#include "kernel/fs.h"
+
+// Throughput of the three ways of hashing a buffer, over a sweep of
+// input sizes:
+//   user     the SHA-256 library linked into this program
+//   syscall  sha256encrypt(), which copies the input into the kernel
+//   fd       sha256fd() on a file holding the input
+// Each measurement repeats until MIN_TIME has passed and is timed
+// with rdtime() and rdcycle(). Output is one whitespace-separated
+// row per path and size, after a header naming the columns:
+//   path size runs MB/s cycles/byte
+// Comment lines, starting with '#', report skipped rows and errors.
+
+// Shortest time one measurement runs for, in rdtime units (0.1 s)
+#define MIN_TIME (TIMER_HZ / 10)
+
+// Largest file xv6 can hold. The fd path skips larger sizes.
+#define FD_MAXSIZE (MAXFILE * BSIZE)
+
+#define BENCH_FILE "sha256bench.tmp"
+
+static const int sizes[] = {
+    64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 10485760
+};
+
+#define PATH_USER    0
+#define PATH_SYSCALL 1
+#define PATH_FD      2
+
+const char *path_names[] = { "user", "syscall", "fd" };
+
+// Write size + 1 bytes of buf to BENCH_FILE and return it open for
+// reading, or -1 if the file system has no room. The fd path hashes
+// only the first size bytes: a digest of part of a file is never
+// answered from the kernel digest cache, so every run really reads
+// and hashes the data.
+int make_file(char *buf, int size) {
+    int fd, n;
+
+    if ((fd = open(BENCH_FILE, O_CREATE | O_TRUNC | O_WRONLY)) < 0)
+        return -1;
+    n = write(fd, buf, size + 1);
+    close(fd);
+    if (n != size + 1)
+        return -1;
+    return open(BENCH_FILE, O_RDONLY);
+}
+
+// Hash size bytes along one path until MIN_TIME has passed, check
+// the digest against expect, and print the row.
+void measure(int path, char *buf, int size, int fd, uchar *expect) {
+    uchar hash[32];
+    uint64 start_time, start_cycles, elapsed, cycles, total;
+    int runs = 0, r = 0;
+
+    start_time = rdtime();
+    start_cycles = rdcycle();
+    do {
+        switch (path) {
+        case PATH_USER:
+            sha256((uchar *)buf, size, hash);
+            break;
+        case PATH_SYSCALL:
+            r = sha256encrypt(buf, size, hash);
+            break;
+        case PATH_FD:
+            r = sha256fd(fd, 0, size, hash) == size ? 0 : -1;
+            break;
+        }
+        if (r < 0) {
+            printf("%s hashing of %d bytes failed\n", path_names[path], size);
+            exit(1);
+        }
+        runs++;
+    } while ((elapsed = rdtime() - start_time) < MIN_TIME);
+    cycles = rdcycle() - start_cycles;
+
+    if (memcmp(hash, expect, 32) != 0)
+        printf("# %s digest mismatch at %d bytes\n", path_names[path], size);
+
+    total = (uint64)size * runs;
+    printf("%s %d %d ", path_names[path], size, runs);
+    print_fixed(1, total * 100 * (TIMER_HZ / 1000) / (elapsed * 1000));
+    printf(" ");
+    print_fixed(1, cycles * 100 / total);
+    printf("\n");
+}
+
+// Latency histogram in nanoseconds. Values below 16 get a bucket
+// each; above that, every power of two is split into 16 buckets, so
+// a bucket is at most 1/16 wider than the values it holds.
+#define HIST_BUCKETS ((63 - 3) * 16 + 16)
+
+struct hist {
+    uint count[HIST_BUCKETS];
+    uint n;
+    uint64 max;
+};
+
+int hist_bucket(uint64 v) {
+    int e = 63;
+
+    if (v < 16)
+        return v;
+    while (!(v >> e))
+        e--;
+    return (e - 3) * 16 + ((v >> (e - 4)) & 15);
+}
+
+// Largest value that falls in bucket b
+uint64 hist_value(int b) {
+    int e = b / 16 + 3;
+
+    if (b < 16)
+        return b;
+    return ((uint64)(16 + b % 16) << (e - 4)) + ((uint64)1 << (e - 4)) - 1;
+}
+
+void hist_add(struct hist *h, uint64 v) {
+    h->count[hist_bucket(v)]++;
+    h->n++;
+    if (v > h->max)
+        h->max = v;
+}
+
+// Value at or below which permille thousandths of the samples lie
+uint64 hist_percentile(struct hist *h, int permille) {
+    uint64 rank = ((uint64)h->n * permille + 999) / 1000;
+    uint64 seen = 0;
+
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += h->count[b];
+        if (seen >= rank && seen > 0)
+            return hist_value(b) < h->max ? hist_value(b) : h->max;
+    }
+    return h->max;
+}
+
+void hist_print(char *what, int size, struct hist *h) {
+    printf("%s %d %d %d %d %d %d\n", what, size, h->n,
+           (int)hist_percentile(h, 500), (int)hist_percentile(h, 990),
+           (int)hist_percentile(h, 999), (int)h->max);
+}
+
+// For each small message size, time that many single sha256encrypt
+// calls with hrtime() and print percentiles of their latency. A first
+// row times two back-to-back hrtime() calls, the cost of the
+// measurement itself.
+// Columns: what size calls p50 p99 p999 max, all times in ns.
+void latency(int calls) {
+    static const int lat_sizes[] = { 0, 32, 55, 64, 256, 1024 };
+    static struct hist h;
+    char buf[1024];
+    uchar hash[32];
+    uint64 t0, t1;
+
+    for (int i = 0; i < sizeof(buf); i++)
+        buf[i] = i * 7;
+
+    printf("what size calls p50 p99 p999 max\n");
+    memset(&h, 0, sizeof(h));
+    for (int i = 0; i < calls; i++) {
+        t0 = hrtime();
+        t1 = hrtime();
+        hist_add(&h, t1 - t0);
+    }
+    hist_print("hrtime", 0, &h);
+
+    for (int s = 0; s < sizeof(lat_sizes) / sizeof(lat_sizes[0]); s++) {
+        memset(&h, 0, sizeof(h));
+        for (int i = 0; i < calls; i++) {
+            t0 = hrtime();
+            if (sha256encrypt(buf, lat_sizes[s], hash) < 0) {
+                printf("sha256encrypt of %d bytes failed\n", lat_sizes[s]);
+                exit(1);
+            }
+            t1 = hrtime();
+            hist_add(&h, t1 - t0);
+        }
+        hist_print("syscall", lat_sizes[s], &h);
+    }
+}
+
+// Stream benchmark: hash 1 to 10 MB read from disk, either in one
+// process that alternates between read() and hashing, or pipelined,
+// with a forked reader feeding a pipe while this process hashes. No
+// xv6 file is that large, so the stream is STREAM_FILE read over and
+// over; the file is larger than the buffer cache, so every pass goes
+// to the disk.
+#define STREAM_FILE      "sha256bench.stream"
+#define STREAM_FILE_SIZE (128 * 1024)
+#define STREAM_READ      (32 * 1024)  // reads by the sequential hasher
+#define PIPE_CHUNK       1024         // reads by the pipelined reader
+
+// Read STREAM_FILE passes times, chunk bytes per read(), and either
+// hash what is read into ctx or, if ctx is 0, write it to out.
+int stream_passes(char *buf, int chunk, int passes, struct sha256_ctx *ctx, int out) {
+    int fd, n;
+
+    for (int p = 0; p < passes; p++) {
+        if ((fd = open(STREAM_FILE, O_RDONLY)) < 0)
+            return -1;
+        while ((n = read(fd, buf, chunk)) > 0) {
+            if (ctx)
+                sha256_update(ctx, (uchar *)buf, n);
+            else if (write(out, buf, n) != n)
+                break;
+        }
+        close(fd);
+        if (n != 0)
+            return -1;
+    }
+    return 0;
+}
+
+// Hash size bytes of the stream, pipelined or not, print the row,
+// and leave the digest in hash.
+void stream_measure(int pipelined, char *buf, int size, uchar *hash) {
+    struct sha256_ctx ctx;
+    uint64 start, elapsed;
+    int passes = size / STREAM_FILE_SIZE, p[2], n, pid, xstatus = 0;
+
+    start = rdtime();
+    sha256_init(&ctx);
+    if (!pipelined) {
+        if (stream_passes(buf, STREAM_READ, passes, &ctx, -1) < 0)
+            xstatus = 1;
+    } else {
+        if (pipe(p) < 0 || (pid = fork()) < 0) {
+            printf("pipe or fork failed\n");
+            exit(1);
+        }
+        if (pid == 0) {
+            close(p[0]);
+            exit(stream_passes(buf, PIPE_CHUNK, passes, 0, p[1]) < 0 ? 1 : 0);
+        }
+        close(p[1]);
+        while ((n = read(p[0], buf, STREAM_READ)) > 0)
+            sha256_update(&ctx, (uchar *)buf, n);
+        close(p[0]);
+        wait(&xstatus);
+    }
+    sha256_final(&ctx, hash);
+    elapsed = rdtime() - start;
+
+    if (xstatus != 0) {
+        printf("reading %s failed\n", STREAM_FILE);
+        exit(1);
+    }
+    printf("%s %d ", pipelined ? "pipelined" : "sequential", size);
+    print_fixed(1, (uint64)size * 100 * (TIMER_HZ / 1000) / (elapsed * 1000));
+    printf("\n");
+}
+
+// Columns: mode size MB/s
+void stream(void) {
+    static const int stream_sizes[] = { 1 << 20, 2 << 20, 5 << 20, 10 << 20 };
+    uchar seq[32], piped[32];
+    char *buf;
+    int fd;
+
+    if ((buf = malloc(STREAM_FILE_SIZE)) == 0) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int i = 0; i < STREAM_FILE_SIZE; i++)
+        buf[i] = i * 7;
+    if ((fd = open(STREAM_FILE, O_CREATE | O_TRUNC | O_WRONLY)) < 0 ||
+        write(fd, buf, STREAM_FILE_SIZE) != STREAM_FILE_SIZE) {
+        printf("no room for %s\n", STREAM_FILE);
+        unlink(STREAM_FILE);
+        exit(1);
+    }
+    close(fd);
+
+    printf("mode size MB/s\n");
+    for (int s = 0; s < sizeof(stream_sizes) / sizeof(stream_sizes[0]); s++) {
+        stream_measure(0, buf, stream_sizes[s], seq);
+        stream_measure(1, buf, stream_sizes[s], piped);
+        if (memcmp(seq, piped, 32) != 0)
+            printf("# digest mismatch at %d bytes\n", stream_sizes[s]);
+    }
+    unlink(STREAM_FILE);
+    free(buf);
+}
+
+// With "-l [calls]", print latency percentiles of single system
+// calls instead of the throughput sweep; with "-p", compare
+// sequential and pipelined hashing of a disk stream.
+int main(int argc, char *argv[]) {
+    int max = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+    uchar expect[32];
+    char *buf;
+    int fd;
+
+    if (argc >= 2 && strcmp(argv[1], "-l") == 0) {
+        latency(argc > 2 ? atoi(argv[2]) : 10000);
+        exit(0);
+    }
+    if (argc >= 2 && strcmp(argv[1], "-p") == 0) {
+        stream();
+        exit(0);
+    }
+
+    if ((buf = malloc(max + 1)) == 0) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int i = 0; i <= max; i++)
+        buf[i] = i * 7;
+
+    printf("path size runs MB/s cycles/byte\n");
+    for (int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int size = sizes[s];
+
+        sha256((uchar *)buf, size, expect);
+        measure(PATH_USER, buf, size, -1, expect);
+        measure(PATH_SYSCALL, buf, size, -1, expect);
+        if (size >= FD_MAXSIZE)
+            continue;
+        if ((fd = make_file(buf, size)) < 0) {
+            printf("# fd skipped at %d bytes: no room for %s\n", size, BENCH_FILE);
+            continue;
+        }
+        measure(PATH_FD, buf, size, fd, expect);
+        close(fd);
+    }
+    unlink(BENCH_FILE);
+
+    free(buf);
+    exit(0);
+}
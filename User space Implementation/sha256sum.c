@@ -0,0 +1,285 @@
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+#include "kernel/fcntl.h"
+#include "kernel/sha256.h"
+
+// Print the SHA-256 of each file named, or of standard input if
+// there are none, one "digest  name" line each, like sha256sum on
+// other systems; standard input is named "-". Input is read in
+// READ_SIZE blocks and fed to an incremental hash, so files and
+// pipes of any size and content take the same, constant memory.
+//
+// With -j N, N forked workers hash the files in parallel, one file
+// at a time each, so they spread over the harts. Lines still come
+// out in the order the files were named, and the total throughput
+// is reported on standard error.
+//
+// With -p, each file, standard input included, is read by a forked
+// reader process that passes it on through a pipe, PIPE_CHUNK bytes
+// at a time, so the disk reads the next chunk while this process
+// hashes the last one.
+
+#define READ_SIZE (32 * 1024)
+
+#define MAXJOBS 16
+
+// File indices sent to the workers but not yet answered. Kept below
+// the 128 that would fit even in a 512-byte pipe, so the parent never
+// blocks handing out work while workers wait to hand back results.
+#define INFLIGHT 64
+
+// hash_path() errors
+#define SUM_EOPEN -1
+#define SUM_ESTAT -2
+#define SUM_EDIR  -3
+#define SUM_EREAD -4
+
+// A worker's answer for one file. Its size divides the pipe buffer
+// (a power of two, at least 512 bytes), and so does that of the int
+// indices going the other way, so records from different workers
+// are never split or interleaved.
+struct result {
+    int index;              // into the list of files
+    int len;                // bytes hashed, or a SUM_E* error
+    uchar digest[SHA256_DIGEST_SIZE];
+    uchar pad[24];
+};
+
+// Reads by the -p reader: one disk block, so that one chunk can
+// wait in the pipe while the reader fetches the next.
+#define PIPE_CHUNK 1024
+
+static uchar buf[READ_SIZE];
+static int pipelined;
+
+// Hash everything left to read on fd.
+// Returns the number of bytes hashed, or -1 on a read error.
+int hash_fd(int fd, uchar *digest) {
+    struct sha256_ctx ctx;
+    int n, total = 0;
+
+    sha256_init(&ctx);
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        sha256_update(&ctx, buf, n);
+        total += n;
+    }
+    if (n < 0)
+        return -1;
+    sha256_final(&ctx, digest);
+    return total;
+}
+
+// Hash everything left to read on fd, read by a forked reader and
+// passed on through a pipe so that reading and hashing overlap.
+// Returns the number of bytes hashed, or -1 if either side failed.
+int hash_fd_pipelined(int fd, uchar *digest) {
+    int p[2], n, pid, r, xstatus;
+
+    if (pipe(p) < 0)
+        return -1;
+    if ((pid = fork()) < 0) {
+        close(p[0]);
+        close(p[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        close(p[0]);
+        while ((n = read(fd, buf, PIPE_CHUNK)) > 0)
+            if (write(p[1], buf, n) != n)
+                exit(1);
+        exit(n < 0 ? 1 : 0);
+    }
+    close(p[1]);
+    r = hash_fd(p[0], digest);
+    close(p[0]);
+    wait(&xstatus);
+    return xstatus == 0 ? r : -1;
+}
+
+// Hash the file at path, or standard input if path is "-".
+// Returns the number of bytes hashed, or a SUM_E* error.
+int hash_path(char *path, uchar *digest) {
+    struct stat st;
+    int fd, r;
+
+    if (strcmp(path, "-") == 0) {
+        r = pipelined ? hash_fd_pipelined(0, digest) : hash_fd(0, digest);
+        return r < 0 ? SUM_EREAD : r;
+    }
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return SUM_EOPEN;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return SUM_ESTAT;
+    }
+    if (st.type == T_DIR) {
+        close(fd);
+        return SUM_EDIR;
+    }
+    r = pipelined ? hash_fd_pipelined(fd, digest) : hash_fd(fd, digest);
+    close(fd);
+    return r < 0 ? SUM_EREAD : r;
+}
+
+void print_digest(const uchar *digest, const char *name) {
+    static const char hex[] = "0123456789abcdef";
+    char line[2 * SHA256_DIGEST_SIZE + 1];
+
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        line[2 * i] = hex[digest[i] >> 4];
+        line[2 * i + 1] = hex[digest[i] & 15];
+    }
+    line[2 * SHA256_DIGEST_SIZE] = 0;
+    printf("%s  %s\n", line, name);
+}
+
+// Print the line for path, or why it has none.
+// Returns 0, or -1 for an error.
+int report(char *path, int len, const uchar *digest) {
+    switch (len) {
+    case SUM_EOPEN:
+        fprintf(2, "sha256sum: cannot open %s\n", path);
+        return -1;
+    case SUM_ESTAT:
+        fprintf(2, "sha256sum: cannot stat %s\n", path);
+        return -1;
+    case SUM_EDIR:
+        fprintf(2, "sha256sum: %s is a directory\n", path);
+        return -1;
+    case SUM_EREAD:
+        if (strcmp(path, "-") == 0)
+            fprintf(2, "sha256sum: error reading standard input\n");
+        else
+            fprintf(2, "sha256sum: error reading %s\n", path);
+        return -1;
+    }
+    print_digest(digest, path);
+    return 0;
+}
+
+// Worker body: hash each file whose index arrives on in, and write
+// a struct result for it to out, until in reaches end of file.
+void worker(char **paths, int in, int out) {
+    struct result r;
+    int i;
+
+    while (read(in, &i, sizeof(i)) == sizeof(i)) {
+        memset(&r, 0, sizeof(r));
+        r.index = i;
+        r.len = hash_path(paths[i], r.digest);
+        if (write(out, &r, sizeof(r)) != sizeof(r))
+            break;
+    }
+    exit(0);
+}
+
+// Hash n files on jobs workers. The parent hands out file indices
+// over one pipe and collects results over another, and prints each
+// line as soon as every earlier file's line is out.
+// Returns 0, or -1 if any file had an error.
+int sum_parallel(char **paths, int n, int jobs) {
+    struct result r, *results;
+    int work[2], done[2];
+    int sent = 0, received = 0, next = 0, started = 0, status = 0;
+    uint64 start, elapsed, total = 0;
+
+    if ((results = malloc(n * sizeof(*results))) == 0) {
+        fprintf(2, "sha256sum: out of memory\n");
+        return -1;
+    }
+    for (int i = 0; i < n; i++)
+        results[i].index = -1;
+    if (pipe(work) < 0 || pipe(done) < 0) {
+        fprintf(2, "sha256sum: pipe failed\n");
+        return -1;
+    }
+
+    start = rdtime();
+    for (int j = 0; j < jobs; j++) {
+        int pid = fork();
+        if (pid == 0) {
+            close(work[1]);
+            close(done[0]);
+            worker(paths, work[0], done[1]);
+        }
+        if (pid < 0)
+            break;
+        started++;
+    }
+    close(work[0]);
+    close(done[1]);
+    if (started == 0) {
+        fprintf(2, "sha256sum: fork failed\n");
+        close(work[1]);
+        close(done[0]);
+        return -1;
+    }
+
+    while (received < n) {
+        while (sent < n && sent - received < INFLIGHT) {
+            write(work[1], &sent, sizeof(sent));
+            if (++sent == n)
+                close(work[1]);
+        }
+        if (read(done[0], &r, sizeof(r)) != sizeof(r))
+            break;
+        results[r.index] = r;
+        received++;
+        for (; next < n && results[next].index == next; next++) {
+            if (report(paths[next], results[next].len, results[next].digest) < 0)
+                status = -1;
+            else
+                total += results[next].len;
+        }
+    }
+    if (sent < n)
+        close(work[1]);
+    close(done[0]);
+    for (int j = 0; j < started; j++)
+        wait(0);
+    elapsed = rdtime() - start;
+
+    if (received < n) {
+        fprintf(2, "sha256sum: workers exited early\n");
+        status = -1;
+    }
+    fprintf(2, "sha256sum: %d files, %d bytes, %d workers, ", received, (int)total, started);
+    print_fixed(2, elapsed ? total * 100 * (TIMER_HZ / 1000) / (elapsed * 1000) : 0);
+    fprintf(2, " MB/s\n");
+
+    free(results);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    uchar digest[SHA256_DIGEST_SIZE];
+    int status = 0, jobs = 0, first = 1;
+
+    for (; first < argc && argv[first][0] == '-' && argv[first][1] != 0; first++) {
+        if (strcmp(argv[first], "-p") == 0) {
+            pipelined = 1;
+        } else if (strcmp(argv[first], "-j") == 0 && first + 1 < argc) {
+            jobs = atoi(argv[++first]);
+        } else {
+            jobs = -1;
+            break;
+        }
+    }
+    if (jobs < 0 || jobs > MAXJOBS || (jobs > 0 && first >= argc)) {
+        fprintf(2, "Usage: sha256sum [-p] [-j workers] [file...]\n");
+        exit(1);
+    }
+
+    if (first >= argc)
+        exit(report("-", hash_path("-", digest), digest) < 0 ? 1 : 0);
+
+    if (jobs > 0)
+        exit(sum_parallel(argv + first, argc - first, jobs) < 0 ? 1 : 0);
+
+    for (int i = first; i < argc; i++)
+        if (report(argv[i], hash_path(argv[i], digest), digest) < 0)
+            status = 1;
+    exit(status);
+}
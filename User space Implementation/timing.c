@@ -0,0 +1,11 @@
+#include "kernel/types.h"
+#include "user/user.h"
+
+// Output helpers shared by the benchmarks and counter tools, which
+// time with rdtime() (TIMER_HZ per second, from kernel/param.h) and
+// rdcycle().
+
+// Print v, a value scaled by 100, to fd with two decimals.
+void print_fixed(int fd, uint64 v) {
+    fprintf(fd, "%d.%d%d", (int)(v / 100), (int)(v / 10 % 10), (int)(v % 10));
+}